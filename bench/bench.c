@@ -0,0 +1,291 @@
+/* dk window manager
+ *
+ * headless layout benchmark, every entry in layouts[] is run against
+ * synthetic workspaces with the X side of dk stubbed out below
+ *
+ * see license file for copyright and license details
+ * vim:ft=c:fdm=syntax:ts=4:sts=4:sw=4
+ */
+
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <xcb/randr.h>
+#include <xcb/xcb_aux.h>
+#include <xcb/xcb_util.h>
+#include <xcb/xcb_keysyms.h>
+
+#include "dk.h"
+#include "cmd.h"
+#include "util.h"
+#include "layout.h"
+#include "config.h"
+
+/* time spent on each case before moving on, in nanoseconds */
+#define BENCH_NS 20000000L
+
+typedef struct Scenario {
+	const char *name;
+	int w, h, gap, pad, nmaster, nstack, hoff;
+	float msplit, ssplit;
+} Scenario;
+
+static const Scenario scenarios[] = {
+	{"default", 1920, 1080, 0,  0,  1, 3, 0,  0.5,  0.5 },
+	{"gaps",    1920, 1080, 12, 20, 1, 3, 0,  0.5,  0.5 },
+	{"splits",  1920, 1080, 4,  0,  3, 5, 0,  0.95, 0.05},
+	{"hoff",    1920, 1080, 4,  0,  2, 4, 40, 0.5,  0.5 },
+	{"tiny",    640,  360,  8,  10, 1, 3, 0,  0.5,  0.5 },
+};
+
+static const int counts[] = {1, 2, 3, 4, 5, 10, 25, 100, 1000};
+
+static struct {
+	unsigned long configures, popped, syncs;
+} tally;
+
+xcb_connection_t *con;
+Workspace *selws;
+
+/* the handful of dk.c functions layouts call that send requests, trimmed
+ * down to the geometry bookkeeping so the requests a pass would send can be
+ * counted, nexttiled() and tilecount() are the real ones from layout.c */
+int clientgeom(Client *c, int x, int y, int w, int h, int bw)
+{
+	w = MAX(w, globalcfg[GLB_MIN_WH].val);
+	h = MAX(h, globalcfg[GLB_MIN_WH].val);
+	if (x == c->sent.x && y == c->sent.y && w == c->sent.w && h == c->sent.h && bw == c->sent.bw) {
+		return 0;
+	}
+	c->sent.x = x, c->sent.y = y, c->sent.w = w, c->sent.h = h, c->sent.bw = bw;
+	tally.configures++;
+	return 1;
+}
+
+void sendconfigure(__attribute__((unused)) Client *c)
+{
+}
+
+void resizehint(Client *c, int x, int y, int w, int h, int bw, __attribute__((unused)) int usermotion,
+				__attribute__((unused)) int mouse)
+{
+	c->x = x, c->y = y, c->bw = bw;
+	c->w = MAX(w, globalcfg[GLB_MIN_WH].val);
+	c->h = MAX(h, globalcfg[GLB_MIN_WH].val);
+	clientgeom(c, c->x, c->y, c->w, c->h, c->bw);
+}
+
+void clientmove(Client *c, int x, int y)
+{
+	clientgeom(c, x, y, c->w, c->h, c->bw);
+}
+
+void popfloat(Client *c)
+{
+	c->state |= STATE_FLOATING;
+	tally.popped++;
+	resizehint(c, c->x, c->y, MON(c)->ww / 3, MON(c)->wh / 3, c->bw, 0, 0);
+}
+
+void xcb_aux_sync(__attribute__((unused)) xcb_connection_t *c)
+{
+	tally.syncs++;
+}
+
+/* config.h callbacks and commands, never called from a layout */
+void focus(__attribute__((unused)) Client *c)
+{
+}
+
+void gravitate(__attribute__((unused)) Client *c, __attribute__((unused)) int horz,
+			   __attribute__((unused)) int vert, __attribute__((unused)) int matchgap)
+{
+}
+
+void setfullscreen(__attribute__((unused)) Client *c, __attribute__((unused)) int fullscreen)
+{
+}
+
+#define CMD(name)                                                                                            \
+	int name(__attribute__((unused)) char **argv)                                                            \
+	{                                                                                                        \
+		return 0;                                                                                            \
+	}
+#define WSCMD(name)                                                                                          \
+	int name(__attribute__((unused)) Workspace *ws)                                                          \
+	{                                                                                                        \
+		return 0;                                                                                            \
+	}
+CMD(cmdborder)
+CMD(cmdcycle)
+CMD(cmdexit)
+CMD(cmdfakefull)
+CMD(cmdfloat)
+CMD(cmdfocus)
+CMD(cmdfull)
+CMD(cmdgappx)
+CMD(cmdkill)
+CMD(cmdlayout)
+CMD(cmdmon)
+CMD(cmdmors)
+CMD(cmdmouse)
+CMD(cmdmvstack)
+CMD(cmdpad)
+CMD(cmdreload)
+CMD(cmdresize)
+CMD(cmdrestart)
+CMD(cmdrule)
+CMD(cmdscratch)
+CMD(cmdset)
+CMD(cmdsplit)
+CMD(cmdstatus)
+CMD(cmdstick)
+CMD(cmdswap)
+CMD(cmdwin)
+CMD(cmdws)
+WSCMD(cmdfollow)
+WSCMD(cmdsend)
+WSCMD(cmdview)
+#undef CMD
+#undef WSCMD
+
+static long now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+/* one pass the way refresh() runs it, returns whether the layout reported
+ * the minimum size was exceeded */
+static int pass(Workspace *ws)
+{
+	return layoutws(ws) < 0;
+}
+
+/* time only the geometry solver, nothing is applied */
+static double solve(Workspace *ws, int n)
+{
+	long start, end;
+	unsigned long iters = 0;
+	Geom *geo = ecalloc(n, sizeof(Geom));
+
+	start = now();
+	do {
+		ws->layout->func(ws, geo, n);
+		iters++;
+	} while ((end = now()) - start < BENCH_NS);
+	free(geo);
+	return (double)(end - start) / iters;
+}
+
+/* tiled clients that ended up with no area or entirely off the monitor */
+static int misplaced(Workspace *ws)
+{
+	int bad = 0;
+	Monitor *m = ws->mon;
+
+	for (Client *c = nexttiled(ws->clients); c; c = nexttiled(c->next)) {
+		if (ws->layout->func == mono && c != ws->sel) {
+			continue;
+		}
+		if (c->w < 1 || c->h < 1 || c->x >= m->x + m->w || c->y >= m->y + m->h || c->x + W(c) <= m->x ||
+			c->y + H(c) <= m->y) {
+			bad++;
+		}
+	}
+	return bad;
+}
+
+static void run(Layout *l, int n, const Scenario *s)
+{
+	long start, end;
+	const char *name = l->name;
+	unsigned long iters = 0, cold, warm, popped, syncs;
+	int retries, bad, tiled;
+	double passns, solvens, hitns;
+	Client *clients = ecalloc(n, sizeof(Client));
+	Monitor m = {.num = 0, .connected = 1, .w = s->w, .h = s->h, .ww = s->w, .wh = s->h, .rate = 60};
+	Workspace ws = {
+		.nmaster = s->nmaster,
+		.nstack = s->nstack,
+		.gappx = s->gap,
+		.padl = s->pad,
+		.padr = s->pad,
+		.padt = s->pad,
+		.padb = s->pad,
+		.msplit = s->msplit,
+		.ssplit = s->ssplit,
+		.layout = l,
+		.mon = &m,
+		.clients = clients,
+		.sel = clients,
+	};
+
+	for (int i = 0; i < n; i++) {
+		clients[i].ws = &ws;
+		clients[i].bw = border[BORD_WIDTH];
+		clients[i].hoff = i % 2 ? -s->hoff : s->hoff;
+		clients[i].next = i + 1 < n ? &clients[i + 1] : NULL;
+	}
+	selws = &ws;
+	m.ws = &ws;
+
+	/* first pass from nothing then an identical one which should be free,
+	 * anything popped to floating stays that way like it would in dk */
+	memset(&tally, 0, sizeof(tally));
+	retries = pass(&ws);
+	cold = tally.configures;
+	popped = tally.popped;
+	bad = misplaced(&ws);
+	tally.configures = 0;
+	ws.lytkey = 0;
+	pass(&ws);
+	warm = tally.configures;
+
+	/* full passes, the memoized result from the last one is thrown away */
+	tally.syncs = 0;
+	start = now();
+	do {
+		ws.lytkey = 0;
+		pass(&ws);
+		iters++;
+	} while ((end = now()) - start < BENCH_NS);
+	passns = (double)(end - start) / iters;
+	syncs = tally.syncs / iters;
+
+	/* passes where nothing changed */
+	iters = 0;
+	start = now();
+	do {
+		pass(&ws);
+		iters++;
+	} while ((end = now()) - start < BENCH_NS);
+	hitns = (double)(end - start) / iters;
+	solvens = (tiled = tilecount(&ws)) ? solve(&ws, tiled) : 0;
+
+	printf("%-10s %7d  %-8s %12.0f %12.0f %10.0f %8lu %8lu %7d %7lu %6lu %5d\n", name, n, s->name, passns,
+		   solvens, hitns, cold, warm, retries, popped, syncs, bad);
+	free(ws.tiled);
+	free(clients);
+}
+
+int main(void)
+{
+	printf("%-10s %7s  %-8s %12s %12s %10s %8s %8s %7s %7s %6s %5s\n", "layout", "clients", "case", "ns/pass",
+		   "ns/solve", "ns/hit", "cold", "warm", "retry", "popped", "syncs", "bad");
+	for (Layout *l = layouts; l->name; l++) {
+		if (!l->func) {
+			continue;
+		}
+		for (uint32_t i = 0; i < LEN(counts); i++) {
+			for (uint32_t j = 0; j < LEN(scenarios); j++) {
+				run(l, counts[i], &scenarios[j]);
+			}
+		}
+	}
+	return 0;
+}
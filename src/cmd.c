@@ -56,7 +56,7 @@ int adjustisetting(int i, int rel, int *val, int other, int border)
 	n = CLAMP(*val + i, 0, border ? (max / 6) - other : max / globalcfg[GLB_MIN_WH].val);
 	if (n != *val) {
 		*val = n;
-		needsrefresh = 1;
+		setdirty(setws, DIRTY_LAYOUT);
 	}
 	return 0;
 }
@@ -179,7 +179,7 @@ int cmdborder(char **argv)
 	Client *c;
 	Workspace *ws;
 	int i, nparsed = 0, rel, col = 0, first;
-	int bw = border[BORD_WIDTH], old = border[BORD_WIDTH], ow = border[BORD_O_WIDTH];
+	int bw = border[BORD_WIDTH], old = border[BORD_WIDTH], ow = border[BORD_O_WIDTH], oldow = ow;
 
 #define COLOUR(type)                                                                                         \
 	if (!(++argv) || parsecolour(*argv, &border[BORD_##type]) < 0) goto badvalue
@@ -216,6 +216,8 @@ int cmdborder(char **argv)
 				continue;
 			}
 			first = 0, nparsed++;
+			/* borders are drawn on every client, not just the ones shown */
+			setdirty(NULL, DIRTY_ALL);
 #undef COLOUR
 		} else {
 			break;
@@ -230,6 +232,9 @@ badvalue:
 	} else if (bw - ow > 0) {
 		border[BORD_O_WIDTH] = ow;
 	}
+	if ((uint32_t)bw != border[BORD_WIDTH] || border[BORD_O_WIDTH] != (uint32_t)oldow) {
+		setdirty(NULL, DIRTY_ALL);
+	}
 	border[BORD_WIDTH] = bw;
 
 	for (ws = workspaces; ws; ws = ws->next) {
@@ -290,7 +295,7 @@ int cmdfakefull(__attribute__((unused)) char **argv)
 		if (!STATE(c, FAKEFULL)) {
 			resize(c, MON(c)->x, MON(c)->y, MON(c)->w, MON(c)->h, 0);
 		}
-		needsrefresh = 1;
+		setdirty(c->ws, DIRTY_ALL);
 	}
 	return 0;
 }
@@ -350,7 +355,7 @@ int cmdfloat(char **argv)
 	} else {
 		c->old_x = c->x, c->old_y = c->y, c->old_w = c->w, c->old_h = c->h;
 	}
-	needsrefresh = 1;
+	setdirty(c->ws, DIRTY_ALL);
 	return nparsed;
 }
 
@@ -438,10 +443,7 @@ int cmdkill(__attribute__((unused)) char **argv)
 		xcb_grab_server(con);
 		xcb_set_close_down_mode(con, XCB_CLOSE_DOWN_DESTROY_ALL);
 		xcb_kill_client(con, cmdc->win);
-		xcb_aux_sync(con);
 		xcb_ungrab_server(con);
-	} else {
-		xcb_aux_sync(con);
 	}
 	ignore(XCB_ENTER_NOTIFY);
 	return 0;
@@ -456,7 +458,8 @@ int cmdlayout(char **argv)
 				for (n = 0; layouts[n].name; n++)
 					;
 				setws->layout = &layouts[(i + 1) % n];
-				needsrefresh = lytchange = 1;
+				setdirty(setws, DIRTY_ALL);
+				lytchange = 1;
 				break;
 			}
 		}
@@ -468,7 +471,8 @@ int cmdlayout(char **argv)
 		if (!strcmp(slayouts[i], *argv)) {
 			if (&layouts[i] != setws->layout) {
 				setws->layout = &layouts[i];
-				needsrefresh = lytchange = 1;
+				setdirty(setws, DIRTY_ALL);
+				lytchange = 1;
 			}
 			return 1;
 		}
@@ -585,7 +589,7 @@ int cmdpad(char **argv)
 	argv++, nparsed++, orig = v;                                                                             \
 	if (!argv || (i = parseintclamp(*argv, &rel, v * -1, max)) == INT_MIN) goto badvalue;                    \
 	v = CLAMP(rel ? v + i : i, 0, max);                                                                      \
-	needsrefresh = needsrefresh || v != orig
+	if (v != orig) setdirty(setws, DIRTY_LAYOUT)
 
 	while (*argv) {
 		if (!strcmp("l", *argv) || !strcmp("left", *argv)) {
@@ -608,12 +612,34 @@ badvalue:
 #undef PAD
 }
 
+int cmdreload(__attribute__((unused)) char **argv)
+{
+	FILE *f;
+	size_t len = 0;
+	char *errs = NULL;
+
+	if (!(f = open_memstream(&errs, &len))) {
+		respond(cmdresp, "!unable to open error stream: %s", strerror(errno));
+		return -1;
+	}
+	if (loadcfg(f) == -1) {
+		respond(cmdresp, "!unable to load config file, is it missing or already loading?");
+	}
+	fclose(f);
+	if (len) {
+		errs[len - 1] = '\0';
+		respond(cmdresp, "!%s", errs);
+	}
+	free(errs);
+	return 0;
+}
+
 int cmdresize(char **argv)
 {
-	Client *c = cmdc, *t;
+	Client *c = cmdc;
 	Workspace *ws = c ? c->ws : selws;
 	float f, *sf;
-	int i, nparsed = 0;
+	int i, n, nparsed = 0;
 	int xgrav = GRAV_NONE, ygrav = GRAV_NONE;
 	int x = INT_MIN, y = INT_MIN, w = INT_MIN, h = INT_MIN, bw = INT_MIN;
 	int ohoff, relx = 0, rely = 0, relw = 0, relh = 0, relbw = 0;
@@ -660,7 +686,7 @@ badvalue:
 			if ((c->bw = bw) == 0) {
 				c->state |= STATE_NOBORDER;
 			}
-			needsrefresh = 1;
+			setdirty(c->ws, DIRTY_LAYOUT);
 		}
 	}
 
@@ -689,7 +715,7 @@ badvalue:
 			if (ws->layout->func == rtile) {
 				w += w * -2;
 			}
-			for (i = 0, t = nexttiled(ws->clients); t && t != c; t = nexttiled(t->next), i++)
+			for (i = 0, n = tilecount(ws); i < n && ws->tiled[i] != c; i++)
 				;
 			sf = (ws->nmaster && i < ws->nmaster + ws->nstack) ? &ws->msplit : &ws->ssplit;
 			f = relw ? ((ws->mon->ww * *sf) + w) / ws->mon->ww : (float)w / ws->mon->ww;
@@ -698,14 +724,14 @@ badvalue:
 			} else {
 				*sf = f;
 				if (h == INT_MIN) {
-					ws->layout->func(ws);
+					layoutws(ws);
 				}
 			}
 		}
 		if (h != INT_MIN) {
 			ohoff = c->hoff;
 			c->hoff = relh ? c->hoff + h : h;
-			if (ws->layout->func(ws) < 0) {
+			if (layoutws(ws) < 0) {
 				respond(cmdresp, "!height offset exceeded limit: %d", c->hoff);
 				c->hoff = ohoff;
 			}
@@ -720,11 +746,10 @@ badvalue:
 			respond(cmdresp, "!%s exceeded limit: %f", w != INT_MIN ? "width" : "height", ws->mon->ww * f);
 		} else {
 			ws->msplit = f;
-			ws->layout->func(ws);
+			layoutws(ws);
 		}
 	}
 end:
-	xcb_aux_sync(con);
 	ignore(XCB_ENTER_NOTIFY);
 	return nparsed;
 #undef ARG
@@ -927,7 +952,7 @@ applyall:
 						}
 					}
 				}
-				needsrefresh = 1;
+				setdirty(NULL, DIRTY_ALL);
 			}
 		}
 	}
@@ -1025,7 +1050,8 @@ push:
 
 end:
 	xcb_flush(con);
-	needsrefresh = winchange = wschange = 1;
+	setdirty(selws, DIRTY_ALL);
+	winchange = wschange = 1;
 	return nparsed;
 }
 
@@ -1048,11 +1074,11 @@ int cmdsend(Workspace *ws)
 			DBG("cmdsend: resizing floating window: 0x%08x %s x=%d, y=%d, "
 				"w=%d, h=%d",
 				c->win, c->title, c->x, c->y, c->w, c->h)
-			MOVERESIZE(c->win, c->x, c->y, c->w, c->h, c->bw);
+			clientgeom(c, c->x, c->y, c->w, c->h, c->bw);
 		}
 		showhide(ws->stack);
 		showhide(selws->stack);
-		needsrefresh = 1;
+		setdirty(ws, DIRTY_ALL);
 		wschange = c->ws->clients->next ? wschange : 1;
 	}
 	return 0;
@@ -1114,7 +1140,9 @@ int cmdset(char **argv)
 			for (j = 0; j < LEN(globalcfg); j++) {
 				if ((match = !strcmp(globalcfg[j].str, *argv))) {
 					argv++, nparsed++;
-					needsrefresh = needsrefresh || globalcfg[j].val != i;
+					if (globalcfg[j].val != i) {
+						setdirty(NULL, DIRTY_ALL);
+					}
 					switch (globalcfg[j].type) {
 						case TYPE_BOOL:
 							if (!argv || (i = parsebool(*argv)) < 0) {
@@ -1186,7 +1214,8 @@ int cmdsplit(char **argv)
 		if (setws->layout->func && f != 0.0) {
 			float nf = rel ? CLAMP(f + *ff, 0.05, 0.95) : CLAMP(f, 0.05, 0.95);
 			if (nf != *ff) {
-				*ff = nf, needsrefresh = 1;
+				*ff = nf;
+				setdirty(setws, DIRTY_LAYOUT);
 			}
 		}
 		return 1;
@@ -1207,13 +1236,15 @@ int cmdstatus(char **argv)
 			} else if (!strcmp("bar", *argv)) {
 				s.type = STAT_BAR;
 			} else if (!strcmp("win", *argv)) {
-				s.type = STAT_WIN, winchange = 1;
+				s.type = STAT_WIN;
 			} else if (!strcmp("ws", *argv)) {
-				s.type = STAT_WS, wschange = 1;
+				s.type = STAT_WS;
 			} else if (!strcmp("layout", *argv)) {
-				s.type = STAT_LYT, lytchange = 1;
+				s.type = STAT_LYT;
 			} else if (!strcmp("full", *argv)) {
 				s.type = STAT_FULL;
+			} else if (!strcmp("delta", *argv)) {
+				s.type = STAT_DELTA;
 			} else {
 				goto badvalue;
 			}
@@ -1223,12 +1254,50 @@ int cmdstatus(char **argv)
 				goto badvalue;
 			}
 			s.num = i;
+		} else if (!strcmp("rate", *argv)) {
+			argv++, nparsed++;
+			if (!*argv || (i = parseintclamp(*argv, NULL, 0, 1000)) == INT_MIN) {
+				goto badvalue;
+			}
+			s.rate = i;
 		} else if (!strcmp("file", *argv)) {
 			argv++, nparsed++;
 			if (!*argv) {
 				goto badvalue;
 			}
 			s.path = *argv;
+		} else if (!strcmp("mon", *argv)) {
+			argv++, nparsed++;
+			if (!*argv) {
+				goto badvalue;
+			}
+			s.mon = *argv;
+		} else if (!strcmp("ws", *argv) || !strcmp("fields", *argv)) {
+			/* comma separated lists of workspace numbers or field names */
+			int isws = !strcmp("ws", *argv);
+			argv++, nparsed++;
+			if (!*argv) {
+				goto badvalue;
+			}
+			for (char *tok = *argv, *end; tok; tok = end) {
+				if ((end = strchr(tok, ','))) {
+					*end++ = '\0';
+				}
+				if (isws) {
+					if ((i = parseintclamp(tok, NULL, 1, 256)) == INT_MIN) {
+						goto badvalue;
+					}
+					s.ws[(i - 1) / 32] |= 1u << ((i - 1) % 32);
+				} else {
+					if ((i = parseopt(tok, statfields, LEN(statfields))) < 0) {
+						goto badvalue;
+					}
+					s.fields |= 1u << i;
+				}
+				if (end) {
+					end[-1] = ',';
+				}
+			}
 		} else {
 			break;
 badvalue:
@@ -1307,7 +1376,7 @@ int cmdswap(__attribute__((unused)) char **argv)
 			ATTACH(old, cur->next);
 		}
 	}
-	needsrefresh = 1;
+	setdirty(c->ws, DIRTY_ALL);
 	return 0;
 }
 
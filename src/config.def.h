@@ -27,8 +27,11 @@ GlobalCfg globalcfg[GLB_LAST] = {
 	[GLB_SMART_GAP]    = {1,  TYPE_BOOL,  "smart_gap"},    /* disable gaps in layouts with only one visible window */
 	[GLB_TILE_HINTS]   = {0,  TYPE_BOOL,  "tile_hints"},   /* respect size hints in tiled layouts */
 	[GLB_TILE_TOHEAD]  = {0,  TYPE_BOOL,  "tile_tohead"},  /* place new clients at the tail of the stack */
+	[GLB_TILE_OUTLINE] = {0,  TYPE_BOOL,  "tile_outline"}, /* outline tiled mouse resize and apply on release */
 	[GLB_WS_STATIC]    = {0,  TYPE_BOOL,  "static_ws"},    /* use static workspace assignment */
 	[GLB_OBEY_MOTIF]   = {1,  TYPE_BOOL,  "obey_motif"},   /* obey motif_wm_hints for border drawing on supported windows */
+	[GLB_EVENT_BATCH]  = {64, TYPE_INT,   "event_batch"},  /* maximum X events handled before servicing commands */
+	[GLB_CMD_BATCH]    = {16, TYPE_INT,   "cmd_batch"},    /* maximum commands run from one session before servicing X events */
 };
 
 /* default modifier and buttons for mouse move/resize */
@@ -86,7 +89,7 @@ int focusmaster(__attribute__((unused)) char **argv)
 	return 0;
 }
 
-int tstack(Workspace *ws)
+int tstack(Workspace *ws, Geom *geo, int n)
 {
 	/*
 	 * basic example of a new user-defined layout
@@ -95,13 +98,13 @@ int tstack(Workspace *ws)
 	 *   https://dwm.suckless.org/patches/bottomstack/
 	 *
 	 * additions to work with dk padding, gaps, and other features.
+	 *
+	 * layouts only fill in geo[i] for ws->tiled[i], the n tiled clients,
+	 * dk applies the result afterwards so they never touch the server.
 	 */
 
 	Client *c;
-	int i, n, g, mh, mw, mx, sx, sw = 0;
-
-	if (!(n = tilecount(ws)))
-		return 1;
+	int i, g, mh, mw, mx, sx, sw = 0;
 
 	/* apply the workspace padding */
 	int wx = ws->mon->wx + ws->padl;
@@ -123,25 +126,23 @@ int tstack(Workspace *ws)
 		sw = (ww - g) / (n - ws->nmaster);
 	}
 
-	for (i = 0, mx = sx = wx + g, c = nexttiled(ws->clients); c;
-		 c = nexttiled(c->next), i++) {
+	for (i = 0, mx = sx = wx + g; i < n && (c = ws->tiled[i]); i++) {
 		/* apply smart border */
 		int bw = !globalcfg[GLB_SMART_BORDER].val || n > 1 ? c->bw : 0;
 		if (i < ws->nmaster) { /* master windows */
-			resizehint(c, mx, (wy + wh) - mh, mw - g - (2 * bw),
-					   mh - g - (2 * bw), bw, 0, 0);
-			mx += W(c) + g;
+			geo[i] = (Geom){mx, (wy + wh) - mh, mw - g - (2 * bw),
+							mh - g - (2 * bw), bw, 0};
+			mx += geo[i].w + (2 * bw) + g;
 		} else { /* stack windows */
-			resizehint(c, sx, wy + g, sw - g - (2 * bw),
-					   wh - (mh + (2 * g)) - (2 * bw), bw, 0, 0);
-			sx += W(c) + g;
+			geo[i] = (Geom){sx, wy + g, sw - g - (2 * bw),
+							wh - (mh + (2 * g)) - (2 * bw), bw, 0};
+			sx += geo[i].w + (2 * bw) + g;
 		}
 	}
-	xcb_aux_sync(con);
 	return 1;
 }
 
-int dyntile(Workspace *ws)
+int dyntile(Workspace *ws, Geom *geo, int n)
 {
 	/*
 	 * basic example of a new user-defined layout
@@ -149,16 +150,16 @@ int dyntile(Workspace *ws)
 	 * will switch to grid when the number of tiled clients on a workspace == 4
 	 *
 	 */
-	if (tilecount(ws) == 4) {
+	if (n == 4) {
 		ws->layout->implements_resize = 0;
 		ws->layout->tile_resize = 0;
 		ws->layout->name = "grid";
-		return grid(ws);
+		return grid(ws, geo, n);
 	}
 	ws->layout->implements_resize = 1;
 	ws->layout->tile_resize = 1;
 	ws->layout->name = "tile";
-	return ltile(ws);
+	return ltile(ws, geo, n);
 }
 
 /* New commands and callbacks must be added to the below arrays in order to
@@ -183,6 +184,7 @@ Cmd keywords[] = {
 	{"status",  cmdstatus },
 	{"exit",    cmdexit   },
 	{"restart", cmdrestart},
+	{"reload",  cmdreload },
 
  /* don't add below the terminating null */
 	{NULL,      NULL      }
@@ -15,7 +15,7 @@
 
 #include <sys/un.h>
 #include <sys/wait.h>
-#include <sys/select.h>
+#include <sys/epoll.h>
 #include <sys/socket.h>
 
 #include <stdio.h>
@@ -26,9 +26,11 @@
 #include <regex.h>
 #include <signal.h>
 #include <fcntl.h>
+#include <errno.h>
 #include <err.h>
 
 #include <xcb/randr.h>
+#include <xcb/sync.h>
 #include <xcb/xproto.h>
 #include <xcb/xcb_util.h>
 #include <xcb/xcb_icccm.h>
@@ -51,8 +53,10 @@ FILE *cmdresp;
 char *argv0, sock[256];
 uint32_t lockmask = 0;
 int running, restart, needsrefresh, status_usingcmdresp, depth;
-int scr_h, scr_w, sockfd, randrbase, cmdusemon, winchange, wschange, lytchange;
+int scr_h, scr_w, sockfd, epfd, randrbase, syncbase, cmdusemon, winchange, wschange, lytchange, clichange;
+unsigned long reqelided;
 
+Conn *conns;
 Desk *desks;
 Rule *rules;
 Panel *panels;
@@ -101,6 +105,11 @@ const char *gravs[] = {
 	[GRAV_NONE] = "none",     [GRAV_LEFT] = "left", [GRAV_RIGHT] = "right",
 	[GRAV_CENTER] = "center", [GRAV_TOP] = "top",   [GRAV_BOTTOM] = "bottom",
 };
+const char *statfields[] = {
+	[STATF_NAME] = "name",       [STATF_NUMBER] = "number", [STATF_FOCUSED] = "focused",
+	[STATF_ACTIVE] = "active",   [STATF_MONITOR] = "monitor", [STATF_LAYOUT] = "layout",
+	[STATF_TITLE] = "title",     [STATF_ID] = "id",
+};
 const char *dirs[] = {
 	[DIR_NEXT] = "next",     [DIR_PREV] = "prev",     [DIR_LAST] = "last",
 	[DIR_NEXTNE] = "nextne", [DIR_PREVNE] = "prevne"
@@ -135,53 +144,129 @@ const char *netatoms[] = {
 	[NET_WM_STATE] = "_NET_WM_STATE",
 	[NET_WM_STRUTP] = "_NET_WM_STRUT_PARTIAL",
 	[NET_WM_STRUT] = "_NET_WM_STRUT",
+	[NET_WM_SYNC] = "_NET_WM_SYNC_REQUEST",
+	[NET_WM_SYNCCTR] = "_NET_WM_SYNC_REQUEST_COUNTER",
 	[NET_WM_TYPE] = "_NET_WM_WINDOW_TYPE",
 };
 
 const char *slayouts[LEN(layouts)];
 
+/* everything adoption needs to know about a window, the requests are all sent
+ * together by wincookies() and the replies collected after, any cookie left
+ * unused is discarded by freecookies() so its reply doesn't sit in the queue */
+typedef struct Cookies {
+	xcb_get_window_attributes_cookie_t attr;
+	xcb_get_geometry_cookie_t geom;
+	xcb_res_query_client_ids_cookie_t pid;
+	xcb_get_property_cookie_t type, wmstate, desk, state, motif, netname, wmname, clss, trans, hints, normal, sync,
+		proto;
+} Cookies;
+
+/* index of every window we track so event handlers don't walk all the
+ * client lists, absorbed windows map to the client holding them */
+enum { WIN_CLIENT, WIN_ABSORBED, WIN_PANEL, WIN_DESK };
+typedef struct WinIdx {
+	int type;
+	void *ptr;
+	xcb_window_t win;
+	struct WinIdx *next;
+} WinIdx;
+
+static WinIdx **wintab;
+static uint32_t wintabsize, wintabcount;
+
+/* two-tone border pixmaps are shared by every window with the same size and
+ * colours, when full the least recently used one is freed, windows hold their
+ * own reference to a border pixmap so that's always safe */
+typedef struct BorderPixmap {
+	uint32_t key[7]; /* w, h, bw, outer width, depth, inner and outer colour */
+	uint32_t used;
+	xcb_pixmap_t pmap;
+} BorderPixmap;
+
+static uint32_t bordertick;
+static BorderPixmap borderpixmaps[64];
+static struct {
+	uint8_t depth;
+	xcb_gcontext_t gc;
+} bordergcs[4];
+
 static void absorb(Client *p, Client *c);
 static Client *absorbingclient(xcb_window_t win);
+static xcb_gcontext_t bordergc(uint8_t depth, xcb_drawable_t d);
+static xcb_pixmap_t borderpixmap(Client *c, uint32_t b, uint32_t o, uint32_t in, uint32_t out);
+static int adopt(xcb_window_t win, Cookies *ck, xcb_window_t trans, int scan);
+static void classreply(xcb_get_property_cookie_t *pc, char *clss, char *inst, size_t len);
+static xcb_atom_t clientdesk(Client *c, xcb_get_property_cookie_t *pc);
+static void clientstate(Client *c, xcb_get_property_cookie_t *pc);
 static void desorb(Client *c);
 static int discreteproc(pid_t p, pid_t c);
+static Conn *fdtoconn(int fd);
+static Status *fdtostatus(int fd);
+static void freeconn(Conn *cn);
+static void freecookies(Cookies *ck);
 static void freews(Workspace *ws);
+static void hintsreply(Client *c, xcb_get_property_cookie_t *pc);
+static void initclient(xcb_window_t win, xcb_get_geometry_reply_t *g, Cookies *ck, xcb_atom_t type,
+					   xcb_window_t trans);
+static Conn *initconn(int fd);
+static void initdesk(xcb_window_t win, xcb_get_geometry_reply_t *g, Cookies *ck);
+static void initpanel(xcb_window_t win, xcb_get_geometry_reply_t *g, Cookies *ck);
+static void initwins(void);
 static void initwm(void);
+static void matchrule(Client *c, Rule *wr, xcb_atom_t curws, xcb_atom_t type, int nofocus);
+static int namereply(Client *c, xcb_get_property_cookie_t *net, xcb_get_property_cookie_t *wm);
 static pid_t parentproc(pid_t p);
+static pid_t pidreply(xcb_res_query_client_ids_cookie_t *rc);
+static int propreply(xcb_get_property_cookie_t *pc, xcb_atom_t *ret);
+static void readconn(Conn *cn);
 static void relocatews(Workspace *ws, Monitor *old, int wasvis);
 static int rulecmp(Client *c, Rule *r);
+static int runconn(Conn *cn);
 static int savestate(int restore);
 static void sighandle(int sig);
+static void sizehintsreply(Client *c, xcb_get_property_cookie_t *pc, int uss);
+static void syncfree(Client *c);
+static void syncreply(Client *c, xcb_get_property_cookie_t *pc, xcb_get_property_cookie_t *rc);
+static void syncrequest(Client *c);
 static Client *termforwin(const Client *c);
+static xcb_window_t transreply(xcb_get_property_cookie_t *pc);
 static void updatenetclients(void);
 static void updnetworkspaces(void);
-static xcb_get_window_attributes_reply_t *winattr(xcb_window_t win);
-static void winclass(xcb_window_t win, char *clss, char *inst, size_t len);
+static int watchfd(int fd, uint32_t events);
+static void wincookies(xcb_window_t win, Cookies *ck);
 static xcb_get_geometry_reply_t *wingeom(xcb_window_t win);
-static pid_t winpid(xcb_window_t win);
+static uint32_t winhash(xcb_window_t win, uint32_t size);
+static void winindex(xcb_window_t win, int type, void *ptr);
+static void *winlookup(xcb_window_t win, int type);
 static int winprop(xcb_window_t win, xcb_atom_t prop, xcb_atom_t *ret);
+static void winunindex(xcb_window_t win);
 
 int main(int argc, char *argv[])
 {
-	fd_set read_fds;
-	xcb_generic_event_t *ev;
-	xcb_generic_error_t *e;
-	xcb_query_tree_reply_t *rt;
+	Conn *cn, *next;
+	Status *s;
+	xcb_generic_event_t *ev, *queued;
 	static struct sockaddr_un addr;
-	char *end, buf[PIPE_BUF], *host = NULL;
-	int cmdfd, confd, nfds, dsp = 0, scrn = 0;
+	struct epoll_event events[32];
+	char *end, *host = NULL;
+	int cmdfd, confd, nfds, pending = 0, dsp = 0, scrn = 0;
 
 	/* setup basics */
 	argv0 = argv[0];
 	randrbase = -1;
+	syncbase = -1;
 	running = 1;
 	needsrefresh = 1;
 	depth = 0;
 	sockfd = 0;
+	epfd = -1;
 	restart = 0;
 	cmdusemon = 0;
 	winchange = 0;
 	wschange = 0;
 	lytchange = 0;
+	clichange = 0;
 
 	for (int i = 1; i < argc; i++) {
 		if (!strcmp(argv[i], "-s")) {
@@ -234,6 +319,7 @@ int main(int argc, char *argv[])
 		check(listen(sockfd, SOMAXCONN), "unable to listen on socket");
 	}
 	fcntl(sockfd, F_SETFD, FD_CLOEXEC | fcntl(sockfd, F_GETFD));
+	fcntl(sockfd, F_SETFL, O_NONBLOCK | fcntl(sockfd, F_GETFL));
 
 	/* setup signal handling */
 	struct sigaction sa;
@@ -250,28 +336,13 @@ int main(int argc, char *argv[])
 	while (waitpid(-1, NULL, WNOHANG) > 0)
 		;
 
-	/* apply user settings and rules */
-	execcfg();
+	/* apply user settings and rules, the native config file is run in-process
+	 * and finished before any windows are scanned, the shell dkrc is optional
+	 * when it exists */
+	execcfg(loadcfg(NULL) != -1);
 
 	/* initialize existing windows AFTER config is loaded (rules, etc.) */
-	xcb_query_tree_cookie_t rc = xcb_query_tree(con, root);
-	if (!(rt = xcb_query_tree_reply(con, rc, &e))) {
-		iferr(1, "unable to query tree from root window", e);
-	} else if (rt->children_len) {
-		xcb_window_t *w = xcb_query_tree_children(rt);
-		for (uint32_t i = 0; i < rt->children_len; i++) {
-			if (!wintrans(w[i])) {
-				manage(w[i], 1);
-				w[i] = XCB_WINDOW_NONE;
-			}
-		}
-		for (uint32_t i = 0; i < rt->children_len; i++) {
-			if (w[i] != XCB_WINDOW_NONE) {
-				manage(w[i], 1);
-			}
-		}
-	}
-	free(rt);
+	initwins();
 
 	/* restore state from restart and warp pointer to active window if needed */
 	if (savestate(1) == -1 && monitors->next) {
@@ -279,39 +350,72 @@ int main(int argc, char *argv[])
 		xcb_warp_pointer(con, root, root, 0, 0, 0, 0, m->x + (m->w / 2), m->y + (m->h / 2));
 	}
 
+	/* the X connection and command socket stay registered for the life of the
+	 * loop, command connections and status subscribers come and go */
+	check(epfd = epoll_create1(EPOLL_CLOEXEC), "unable to create epoll instance");
 	confd = xcb_get_file_descriptor(con);
+	check(watchfd(confd, EPOLLIN), "unable to watch X connection");
+	check(watchfd(sockfd, EPOLLIN), "unable to watch socket");
+	for (s = stats; s; s = s->next) {
+		if (fileno(s->file) >= 0) {
+			watchfd(fileno(s->file), 0);
+		}
+	}
+
 	while (running) {
 		xcb_flush(con);
-		FD_ZERO(&read_fds);
-		FD_SET(sockfd, &read_fds);
-		FD_SET(confd, &read_fds);
-		nfds = MAX(confd, sockfd) + 1;
-		if (select(nfds, &read_fds, NULL, NULL, NULL) > 0) {
-			/* socket commands */
-			if (FD_ISSET(sockfd, &read_fds)) {
-				cmdfd = accept(sockfd, NULL, 0);
-				ssize_t n = recv(cmdfd, buf, sizeof(buf) - 1, 0);
-				if (cmdfd > 0 && n > 0) {
-					if (buf[n - 1] == '\n') {
-						n--;
-					}
-					buf[n] = '\0';
-					if (!(cmdresp = fdopen(cmdfd, "w"))) {
-						warn("unable to open the socket as file: %s", sock);
+		/* replies read since the last round can leave events queued
+		 * without the connection being readable again, and either side
+		 * may have work left over from its budget, so don't block */
+		queued = xcb_poll_for_queued_event(con);
+		if ((nfds = epoll_wait(epfd, events, LEN(events), queued || pending ? 0 : statuswait())) == -1) {
+			if (errno != EINTR) {
+				warn("unable to wait for events");
+				free(queued);
+				break;
+			}
+			nfds = 0;
+		}
+		for (int i = 0; i < nfds; i++) {
+			int fd = events[i].data.fd;
+			if (fd == confd) {
+				continue;
+			} else if (fd == sockfd) {
+				/* take every connection waiting in the backlog */
+				while ((cmdfd = accept(sockfd, NULL, 0)) >= 0) {
+					if (!initconn(cmdfd)) {
 						close(cmdfd);
 					}
-					parsecmd(buf);
 				}
-			}
-			/* xcb events */
-			if (FD_ISSET(confd, &read_fds)) {
-				xcb_flush(con);
-				while ((ev = xcb_poll_for_event(con))) {
-					dispatch(ev);
-					free(ev);
+			} else if ((cn = fdtoconn(fd))) {
+				readconn(cn);
+			} else if ((s = fdtostatus(fd))) {
+				if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+					/* subscriber closed their end */
+					freestatus(s);
+				} else {
+					flushstatus(s);
 				}
 			}
 		}
+		/* socket commands, sessions get a limited number per round */
+		for (pending = 0, cn = conns; cn; cn = next) {
+			next = cn->next;
+			if (cn->session && runconn(cn)) {
+				pending = 1;
+			}
+		}
+		/* xcb events, the rest stay queued for the next round */
+		nfds = 0;
+		if (queued) {
+			dispatch(queued);
+			free(queued);
+			nfds++;
+		}
+		while (nfds++ < globalcfg[GLB_EVENT_BATCH].val && (ev = xcb_poll_for_event(con))) {
+			dispatch(ev);
+			free(ev);
+		}
 		if (xcb_connection_has_error(con)) {
 			DBG("main: X connection has error -- %s", "bailing")
 			break;
@@ -319,16 +423,7 @@ int main(int argc, char *argv[])
 		if (needsrefresh) {
 			refresh();
 		}
-		/* handle dead status' and print existing ones if needed */
-		Status *s = stats, *next;
-		while (s) {
-			next = s->next;
-			if (write(fileno(s->file), 0, 0) == -1) {
-				freestatus(s);
-			}
-			s = next;
-		}
-		if (stats && (winchange || wschange || lytchange)) {
+		if (stats && (winchange || wschange || lytchange || clichange || !statuswait())) {
 			printstatus(NULL, 1);
 		}
 	}
@@ -351,38 +446,83 @@ static void absorb(Client *p, Client *c)
 	p->win = c->win;
 	c->win = w;
 
-	/* TODO: this is excessive, find a better way to update client title and class */
-	clientname(p);
-	clientname(c);
-	p->pid = winpid(p->win);
-	c->pid = winpid(c->win);
-	winclass(p->win, p->clss, p->inst, sizeof(p->clss));
-	winclass(c->win, c->clss, c->inst, sizeof(c->clss));
+	/* the windows were swapped so swap what was read from them too,
+	 * both are current so there's no need to ask the server again */
+	Client t = *p;
+	p->pid = c->pid;
+	c->pid = t.pid;
+	memcpy(p->title, c->title, sizeof(p->title));
+	memcpy(c->title, t.title, sizeof(c->title));
+	memcpy(p->clss, c->clss, sizeof(p->clss));
+	memcpy(c->clss, t.clss, sizeof(c->clss));
+	memcpy(p->inst, c->inst, sizeof(p->inst));
+	memcpy(c->inst, t.inst, sizeof(c->inst));
+	p->sent = c->sent;
+	c->sent = t.sent;
+	p->sync = c->sync;
+	c->sync = t.sync;
+	winindex(p->win, WIN_CLIENT, p);
+	winindex(c->win, WIN_ABSORBED, p);
 
 	updatenetclients();
 	p->state |= STATE_NEEDSMAP;
 	wschange = winchange = 1;
+	setdirty(p->ws, DIRTY_ALL);
 	refresh();
 }
 
 static Client *absorbingclient(xcb_window_t win)
 {
-	Client *c;
-	Workspace *ws;
+	return winlookup(win, WIN_ABSORBED);
+}
 
-	for (ws = workspaces; ws; ws = ws->next) {
-		for (c = ws->clients; c; c = c->next) {
-			if (c->absorbed && c->absorbed->win == win) {
-				return c;
-			}
-		}
+static int adopt(xcb_window_t win, Cookies *ck, xcb_window_t trans, int scan)
+{
+	int ret = 0;
+	xcb_generic_error_t *e;
+	xcb_get_geometry_reply_t *g = NULL;
+	xcb_get_window_attributes_reply_t *wa = NULL;
+	xcb_atom_t type = XCB_NONE, state;
+
+	wa = xcb_get_window_attributes_reply(con, ck->attr, &e);
+	ck->attr.sequence = 0;
+	if (!wa) {
+		iferr(0, "unable to get window attributes reply", e);
+		goto end;
 	}
-	for (c = scratch.clients; c; c = c->next) {
-		if (c->absorbed && c->absorbed->win == win) {
-			return c;
+	g = xcb_get_geometry_reply(con, ck->geom, &e);
+	ck->geom.sequence = 0;
+	if (!g) {
+		iferr(0, "unable to get window geometry reply", e);
+		goto end;
+	}
+	DBG("adopt: 0x%08x - %d,%d @ %dx%d", win, g->x, g->y, g->width, g->height)
+	if (propreply(&ck->type, &type)) {
+		DBG("adopt: 0x%08x has NET_WM_TYPE", win);
+		if (type == netatom[NET_TYPE_DOCK]) {
+			initpanel(win, g, ck);
+		} else if (type == netatom[NET_TYPE_DESK]) {
+			initdesk(win, g, ck);
+		} else if (!wa->override_redirect) {
+			goto client;
 		}
+		/* never reached for normal windows, only panels, desktops, and
+		 * override_redirect windows */
+		setwinstate(win, XCB_ICCCM_WM_STATE_NORMAL);
+	} else if (!wa->override_redirect) {
+client:
+		if (scan && !(wa->map_state == XCB_MAP_STATE_VIEWABLE ||
+					  (propreply(&ck->wmstate, &state) && state == XCB_ICCCM_WM_STATE_ICONIC))) {
+			goto end;
+		}
+		initclient(win, g, ck, type, trans);
+		PROP(APPEND, root, netatom[NET_CLIENTS], XCB_ATOM_WINDOW, 32, 1, &win);
 	}
-	return NULL;
+	ret = 1;
+end:
+	free(wa);
+	free(g);
+	return ret;
 }
 
 static void applyrule(Client *c, Rule *r, xcb_atom_t curws, int nofocus)
@@ -512,6 +652,10 @@ void attach(Client *c, int tohead)
 {
 	Client *tail = NULL;
 
+	/* detach() is also used to reorder a list so clients stay indexed
+	 * until they're unmanaged, attaching again just updates the entry */
+	winindex(c->win, WIN_CLIENT, c);
+	setdirty(c->ws, DIRTY_ALL);
 	if (!tohead) {
 		TAIL(tail, c->ws->clients);
 	}
@@ -554,7 +698,7 @@ int assignws(Workspace *ws, Monitor *mon)
 		Monitor *old = ws->mon;
 		ws->mon = mon;
 		relocatews(ws, old, 1);
-		needsrefresh = 1;
+		setdirty(NULL, DIRTY_ALL);
 		wschange = 1;
 	} else {
 		respond(cmdresp, "!unable to assign last/only workspace on monitor");
@@ -563,6 +707,73 @@ int assignws(Workspace *ws, Monitor *mon)
 	return 1;
 }
 
+static xcb_gcontext_t bordergc(uint8_t depth, xcb_drawable_t d)
+{
+	uint32_t i;
+
+	for (i = 0; i < LEN(bordergcs) && bordergcs[i].gc; i++) {
+		if (bordergcs[i].depth == depth) {
+			return bordergcs[i].gc;
+		}
+	}
+	if (i == LEN(bordergcs)) {
+		xcb_free_gc(con, bordergcs[--i].gc);
+	}
+	bordergcs[i].depth = depth;
+	bordergcs[i].gc = xcb_generate_id(con);
+	xcb_create_gc(con, bordergcs[i].gc, d, 0, NULL);
+	return bordergcs[i].gc;
+}
+
+static xcb_pixmap_t borderpixmap(Client *c, uint32_t b, uint32_t o, uint32_t in, uint32_t out)
+{
+	xcb_gcontext_t gc;
+	BorderPixmap *bp, *lru = borderpixmaps;
+	uint32_t key[LEN(lru->key)] = {c->w, c->h, b, o, c->depth, in, out};
+
+	for (bp = borderpixmaps; bp < borderpixmaps + LEN(borderpixmaps); bp++) {
+		if (bp->pmap && !memcmp(bp->key, key, sizeof(key))) {
+			bp->used = ++bordertick;
+			reqelided++;
+			return bp->pmap;
+		}
+		if (bp->used < lru->used) {
+			lru = bp;
+		}
+	}
+
+	xcb_rectangle_t inner[] = {
+		{c->w,         0,            b - o,        c->h + b - o},
+		{c->w + b + o, 0,            b - o,        c->h + b - o},
+		{0,            c->h,         c->w + b - o, b - o       },
+		{0,            c->h + b + o, c->w + b - o, b - o       },
+		{c->w + b + o, c->h + b + o, b,            b           }
+	};
+	xcb_rectangle_t outer[] = {
+		{c->w + b - o, 0,            o,              c->h + (b * 2)},
+		{c->w + b,     0,            o,              c->h + (b * 2)},
+		{0,            c->h + b - o, c->w + (b * 2), o             },
+		{0,            c->h + b,     c->w + (b * 2), o             },
+		{1,            1,            1,              1             }
+	};
+
+	if (lru->pmap) {
+		xcb_free_pixmap(con, lru->pmap);
+	}
+	memcpy(lru->key, key, sizeof(key));
+	lru->used = ++bordertick;
+	lru->pmap = xcb_generate_id(con);
+	/* shared by other windows so it's made against the root, the client's
+	 * window may already be destroyed without us knowing yet */
+	xcb_create_pixmap(con, c->depth, lru->pmap, root, W(c), H(c));
+	gc = bordergc(c->depth, lru->pmap);
+	xcb_change_gc(con, gc, XCB_GC_FOREGROUND, &in);
+	xcb_poly_fill_rectangle(con, lru->pmap, gc, LEN(inner), inner);
+	xcb_change_gc(con, gc, XCB_GC_FOREGROUND, &out);
+	xcb_poly_fill_rectangle(con, lru->pmap, gc, LEN(outer), outer);
+	return lru->pmap;
+}
+
 void changews(Workspace *ws, int swap, int warp)
 {
 	Monitor *m;
@@ -608,7 +819,26 @@ void changews(Workspace *ws, int swap, int warp)
 		showhide(lastws->stack);
 	}
 	PROP(REPLACE, root, netatom[NET_DESK_CUR], XCB_ATOM_CARDINAL, 32, 1, &ws->num);
-	needsrefresh = wschange = 1;
+	setdirty(ws, DIRTY_ALL);
+	wschange = 1;
+}
+
+static void classreply(xcb_get_property_cookie_t *pc, char *clss, char *inst, size_t len)
+{
+	/* it is assumed that class and inst are allocated and the same size */
+	xcb_generic_error_t *e;
+	xcb_icccm_get_wm_class_reply_t p;
+
+	if (!xcb_icccm_get_wm_class_reply(con, *pc, &p, &e)) {
+		iferr(0, "unable to get window class", e);
+		strlcpy(clss, "broken", len);
+		strlcpy(inst, "broken", len);
+	} else {
+		strlcpy(clss, strlen(p.class_name) ? p.class_name : "broken", len);
+		strlcpy(inst, strlen(p.instance_name) ? p.instance_name : "broken", len);
+		xcb_icccm_get_wm_class_reply_wipe(&p);
+	}
+	pc->sequence = 0;
 }
 
 void clientborder(Client *c, int focused)
@@ -619,49 +849,92 @@ void clientborder(Client *c, int focused)
 	uint32_t b = c->bw;
 	uint32_t o = border[BORD_O_WIDTH];
 	uint32_t in = border[focused ? BORD_FOCUS : STATE(c, URGENT) ? BORD_URGENT : BORD_UNFOCUS];
+	uint32_t out = b - o > 0 ? border[focused ? BORD_O_FOCUS : STATE(c, URGENT) ? BORD_O_URGENT : BORD_O_UNFOCUS] : 0;
+	uint32_t drawn[LEN(c->sent.border)] = {c->w, c->h, b, o, in, out};
 
+	/* the pixmap only needs redrawing when its size or colours change */
+	if (!memcmp(drawn, c->sent.border, sizeof(drawn))) {
+		reqelided++;
+		return;
+	}
+	memcpy(c->sent.border, drawn, sizeof(drawn));
 	DBG("clientborder: %s - 0x%08x %s, width=%d, outer_width=%d", focused ? "focus" : "unfocus", c->win,
 		c->title, b, o)
 
 	if (b - o > 0) {
-		uint32_t out = border[focused ? BORD_O_FOCUS : STATE(c, URGENT) ? BORD_O_URGENT : BORD_O_UNFOCUS];
-		xcb_rectangle_t inner[] = {
-			{c->w,         0,            b - o,        c->h + b - o},
-			{c->w + b + o, 0,            b - o,        c->h + b - o},
-			{0,            c->h,         c->w + b - o, b - o       },
-			{0,            c->h + b + o, c->w + b - o, b - o       },
-			{c->w + b + o, c->h + b + o, b,            b           }
-        };
-		xcb_rectangle_t outer[] = {
-			{c->w + b - o, 0,            o,              c->h + (b * 2)},
-			{c->w + b,     0,            o,              c->h + (b * 2)},
-			{0,            c->h + b - o, c->w + (b * 2), o             },
-			{0,            c->h + b,     c->w + (b * 2), o             },
-			{1,            1,            1,              1             }
-        };
-
-		xcb_pixmap_t pmap = xcb_generate_id(con);
-		xcb_gcontext_t gc = xcb_generate_id(con);
-		xcb_create_pixmap(con, c->depth, pmap, c->win, W(c), H(c));
-		xcb_create_gc(con, gc, pmap, XCB_GC_FOREGROUND, &in);
-		xcb_poly_fill_rectangle(con, pmap, gc, LEN(inner), inner);
-		xcb_change_gc(con, gc, XCB_GC_FOREGROUND, &out);
-		xcb_poly_fill_rectangle(con, pmap, gc, LEN(outer), outer);
+		xcb_pixmap_t pmap = borderpixmap(c, b, o, in, out);
 		xcb_change_window_attributes(con, c->win, XCB_CW_BORDER_PIXMAP, &pmap);
-		xcb_free_pixmap(con, pmap);
-		xcb_free_gc(con, gc);
 	} else {
 		xcb_change_window_attributes(con, c->win, XCB_CW_BORDER_PIXEL, &in);
 	}
 	xcb_flush(con);
 }
 
+int clientgeom(Client *c, int x, int y, int w, int h, int bw)
+{
+	uint32_t n = 0, mask = 0, v[5];
+
+	w = MAX(w, globalcfg[GLB_MIN_WH].val);
+	h = MAX(h, globalcfg[GLB_MIN_WH].val);
+	if (x != c->sent.x) {
+		mask |= XCB_CONFIG_WINDOW_X, v[n++] = c->sent.x = x;
+	}
+	if (y != c->sent.y) {
+		mask |= XCB_CONFIG_WINDOW_Y, v[n++] = c->sent.y = y;
+	}
+	if (w != c->sent.w) {
+		mask |= XCB_CONFIG_WINDOW_WIDTH, v[n++] = c->sent.w = w;
+	}
+	if (h != c->sent.h) {
+		mask |= XCB_CONFIG_WINDOW_HEIGHT, v[n++] = c->sent.h = h;
+	}
+	if (bw != c->sent.bw) {
+		mask |= XCB_CONFIG_WINDOW_BORDER_WIDTH, v[n++] = c->sent.bw = bw;
+	}
+	if (!mask) {
+		reqelided++;
+		return 0;
+	}
+	if (grabbing && c->sync.counter && (mask & (XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT))) {
+		syncrequest(c);
+	}
+	xcb_configure_window(con, c->win, mask, v);
+	return 1;
+}
+
+static xcb_atom_t clientdesk(Client *c, xcb_get_property_cookie_t *pc)
+{
+	xcb_atom_t ws;
+
+	if (c->trans) {
+		xcb_discard_reply(con, pc->sequence);
+		pc->sequence = 0;
+		return c->trans->ws->num;
+	}
+	if (!propreply(pc, &ws) || ws > 256) {
+		ws = selws->num;
+	}
+	return ws;
+}
+
 void clienthints(Client *c)
+{
+	xcb_get_property_cookie_t pc = xcb_icccm_get_wm_hints(con, c->win);
+
+	hintsreply(c, &pc);
+}
+
+void clientmove(Client *c, int x, int y)
+{
+	clientgeom(c, x, y, c->sent.w, c->sent.h, c->sent.bw);
+}
+
+static void hintsreply(Client *c, xcb_get_property_cookie_t *pc)
 {
 	xcb_generic_error_t *e;
 	xcb_icccm_wm_hints_t wmh;
 
-	if (xcb_icccm_get_wm_hints_reply(con, xcb_icccm_get_wm_hints(con, c->win), &wmh, &e)) {
+	if (xcb_icccm_get_wm_hints_reply(con, *pc, &wmh, &e)) {
 		if (c == selws->sel && wmh.flags & XCB_ICCCM_WM_HINT_X_URGENCY) {
 			wmh.flags &= ~XCB_ICCCM_WM_HINT_X_URGENCY;
 			xcb_icccm_set_wm_hints(con, c->win, &wmh);
@@ -674,6 +947,7 @@ void clienthints(Client *c)
 	} else {
 		iferr(0, "unable to get window wm hints reply", e);
 	}
+	pc->sequence = 0;
 }
 
 void clientmotif(void)
@@ -710,21 +984,32 @@ void clientmotif(void)
 }
 
 int clientname(Client *c)
+{
+	xcb_get_property_cookie_t net, wm;
+
+	/* ask for both up front, WM_NAME is only used when NET_WM_NAME fails */
+	net = xcb_icccm_get_text_property(con, c->win, netatom[NET_WM_NAME]);
+	wm = xcb_icccm_get_text_property(con, c->win, XCB_ATOM_WM_NAME);
+	return namereply(c, &net, &wm);
+}
+
+static int namereply(Client *c, xcb_get_property_cookie_t *net, xcb_get_property_cookie_t *wm)
 {
 	xcb_generic_error_t *e;
-	xcb_get_property_cookie_t rc;
 	xcb_icccm_get_text_property_reply_t r;
 
-	rc = xcb_icccm_get_text_property(con, c->win, netatom[NET_WM_NAME]);
-	if (!xcb_icccm_get_text_property_reply(con, rc, &r, &e)) {
+	if (xcb_icccm_get_text_property_reply(con, *net, &r, &e)) {
+		xcb_discard_reply(con, wm->sequence);
+	} else {
 		iferr(0, "unable to get NET_WM_NAME text property reply", e);
-		rc = xcb_icccm_get_text_property(con, c->win, XCB_ATOM_WM_NAME);
-		if (!xcb_icccm_get_text_property_reply(con, rc, &r, &e)) {
+		if (!xcb_icccm_get_text_property_reply(con, *wm, &r, &e)) {
 			iferr(0, "unable to get WM_NAME text property reply", e);
 			strlcpy(c->title, "broken", sizeof(c->title));
+			net->sequence = wm->sequence = 0;
 			return 0;
 		}
 	}
+	net->sequence = wm->sequence = 0;
 
 	if (r.name && r.name[0] != '\0' && r.name_len > 0 &&
 		(r.encoding == wmatom[WM_UTF8STR] || r.encoding == XCB_ATOM_STRING)) {
@@ -738,16 +1023,18 @@ int clientname(Client *c)
 
 void clientrule(Client *c, Rule *wr, int nofocus)
 {
-	Rule *r = wr;
 	xcb_atom_t type = 0;
-	xcb_atom_t curws = selws->num;
+	xcb_get_property_cookie_t dc, tc;
 
-	if (c->trans) {
-		curws = c->trans->ws->num;
-	} else if (!winprop(c->win, netatom[NET_WM_DESK], &curws) || curws > 256) {
-		curws = selws->num;
-	}
-	winprop(c->win, netatom[NET_WM_TYPE], &type);
+	dc = xcb_get_property(con, 0, c->win, netatom[NET_WM_DESK], XCB_ATOM_ANY, 0, 1);
+	tc = xcb_get_property(con, 0, c->win, netatom[NET_WM_TYPE], XCB_ATOM_ANY, 0, 1);
+	propreply(&tc, &type);
+	matchrule(c, wr, clientdesk(c, &dc), type, nofocus);
+}
+
+static void matchrule(Client *c, Rule *wr, xcb_atom_t curws, xcb_atom_t type, int nofocus)
+{
+	Rule *r = wr;
 
 	if (!r) {
 		for (r = rules; r; r = r->next) {
@@ -763,15 +1050,13 @@ void clientrule(Client *c, Rule *wr, int nofocus)
 	applyrule(c, NULL, curws, nofocus);
 }
 
-void clientstate(Client *c)
+static void clientstate(Client *c, xcb_get_property_cookie_t *pc)
 {
 	xcb_atom_t *state;
 	xcb_generic_error_t *e;
-	xcb_get_property_cookie_t rc;
 	xcb_get_property_reply_t *r = NULL;
 
-	rc = xcb_get_property(con, 0, c->win, netatom[NET_WM_STATE], XCB_ATOM_ANY, 0, 3);
-	if ((r = xcb_get_property_reply(con, rc, &e))) {
+	if ((r = xcb_get_property_reply(con, *pc, &e))) {
 		if (r->value_len && r->format == 32) {
 			state = xcb_get_property_value(r);
 			for (uint32_t i = 0; i < r->value_len; i++) {
@@ -786,15 +1071,34 @@ void clientstate(Client *c)
 		iferr(0, "unable to get window property reply", e);
 	}
 	free(r);
+	pc->sequence = 0;
+}
+
+void clientsync(Client *c)
+{
+	xcb_get_property_cookie_t pc, rc;
+
+	if (syncbase >= 0) {
+		pc = xcb_get_property(con, 0, c->win, netatom[NET_WM_SYNCCTR], XCB_ATOM_CARDINAL, 0, 1);
+		rc = xcb_icccm_get_wm_protocols(con, c->win, wmatom[WM_PROTO]);
+		syncreply(c, &pc, &rc);
+	}
 }
 
 void clienttype(Client *c)
 {
-	xcb_atom_t type;
+	xcb_atom_t type = XCB_NONE;
+	xcb_get_property_cookie_t tc, rc;
 
-	if ((winprop(c->win, netatom[NET_WM_TYPE], &type) &&
-		 (type == netatom[NET_TYPE_DIALOG] || type == netatom[NET_TYPE_SPLASH])) ||
-		c->trans || (c->trans = wintoclient(wintrans(c->win)))) {
+	tc = xcb_get_property(con, 0, c->win, netatom[NET_WM_TYPE], XCB_ATOM_ANY, 0, 1);
+	rc = xcb_icccm_get_wm_transient_for(con, c->win);
+	propreply(&tc, &type);
+	if (c->trans) {
+		xcb_discard_reply(con, rc.sequence);
+	} else {
+		c->trans = wintoclient(transreply(&rc));
+	}
+	if (type == netatom[NET_TYPE_DIALOG] || type == netatom[NET_TYPE_SPLASH] || c->trans) {
 		c->state |= STATE_FLOATING;
 	}
 }
@@ -814,15 +1118,22 @@ Monitor *coordtomon(int x, int y)
 void desorb(Client *c)
 {
 	DBG("desorb: 0x%08x %s -- c->win = 0x%08x %s", c->win, c->title, c->absorbed->win, c->absorbed->title)
+	winunindex(c->win);
 	c->win = c->absorbed->win;
+	winindex(c->win, WIN_CLIENT, c);
+	c->pid = c->absorbed->pid;
+	c->sent = c->absorbed->sent;
+	syncfree(c);
+	c->sync = c->absorbed->sync;
+	strlcpy(c->clss, c->absorbed->clss, sizeof(c->clss));
+	strlcpy(c->inst, c->absorbed->inst, sizeof(c->inst));
 	free(c->absorbed);
 	c->absorbed = NULL;
 	setfullscreen(c, 0);
 	clientname(c);
-	c->pid = winpid(c->win);
-	winclass(c->win, c->clss, c->inst, sizeof(c->clss));
 	wschange = winchange = 1;
 	c->state |= STATE_NEEDSMAP;
+	setdirty(c->ws, DIRTY_ALL);
 	refresh();
 }
 
@@ -839,6 +1150,7 @@ void detach(Client *c, int reattach)
 	Client **cc = &c->ws->clients;
 
 	DETACH(c, cc);
+	setdirty(c->ws, DIRTY_ALL);
 	if (reattach) {
 		ATTACH(c, c->ws->clients);
 	}
@@ -895,7 +1207,7 @@ static int savestate(int restore)
 			t->state |= STATE_FLOATING;
 			if (VISIBLE(t)) {
 				resizehint(t, c.x, c.y, c.w, c.h, c.bw, 0, 0);
-				needsrefresh = 1;
+				setdirty(t->ws, DIRTY_ALL);
 			} else {
 				t->x = c.x, t->y = c.y, t->w = c.w, t->h = c.h; t->bw = c.bw;
 			}
@@ -929,7 +1241,7 @@ static int savestate(int restore)
 	return 0;
 }
 
-void execcfg(void)
+void execcfg(int optional)
 {
 	char *cfg, *s, path[PATH_MAX];
 
@@ -943,6 +1255,12 @@ void execcfg(void)
 		cfg = path;
 	}
 
+	if (access(cfg, X_OK) == -1) {
+		if (!optional) {
+			warn("unable to execute config file: %s", cfg);
+		}
+		return;
+	}
 	if (!fork()) {
 		if (con) {
 			close(xcb_get_file_descriptor(con));
@@ -954,6 +1272,24 @@ void execcfg(void)
 	}
 }
 
+static Conn *fdtoconn(int fd)
+{
+	Conn *cn;
+
+	for (cn = conns; cn && cn->fd != fd; cn = cn->next)
+		;
+	return cn;
+}
+
+static Status *fdtostatus(int fd)
+{
+	Status *s;
+
+	for (s = stats; s && fileno(s->file) != fd; s = s->next)
+		;
+	return s;
+}
+
 void fillstruts(Panel *p)
 {
 	int *s;
@@ -1002,12 +1338,8 @@ void focus(Client *c)
 		selws->sel = c;
 		cmdc = c;
 		if (selws->layout->func == mono) {
-			/* resizehint won't move the window when nothing has changed
-			 * so we force it on this window by incrementing the width */
-			c->w++;
-			mono(selws);
+			layoutws(selws);
 			ignore(XCB_ENTER_NOTIFY);
-			xcb_aux_sync(con);
 		}
 	} else {
 		unfocus(NULL, 1);
@@ -1016,6 +1348,39 @@ void focus(Client *c)
 	winchange = 1;
 }
 
+static void freeconn(Conn *cn)
+{
+	Conn **cc = &conns;
+
+	DETACH(cn, cc);
+	if (cn->fd >= 0) {
+		epoll_ctl(epfd, EPOLL_CTL_DEL, cn->fd, NULL);
+		if (cn->resp) {
+			fclose(cn->resp);
+		} else {
+			close(cn->fd);
+		}
+	}
+	free(cn->buf);
+	free(cn);
+}
+
+static void freecookies(Cookies *ck)
+{
+	unsigned int seq[] = {
+		ck->attr.sequence,    ck->geom.sequence,   ck->pid.sequence,   ck->type.sequence,
+		ck->wmstate.sequence, ck->desk.sequence,   ck->state.sequence, ck->motif.sequence,
+		ck->netname.sequence, ck->wmname.sequence, ck->clss.sequence,  ck->trans.sequence,
+		ck->hints.sequence,   ck->normal.sequence, ck->sync.sequence,  ck->proto.sequence,
+	};
+
+	for (uint32_t i = 0; i < LEN(seq); i++) {
+		if (seq[i]) {
+			xcb_discard_reply(con, seq[i]);
+		}
+	}
+}
+
 static void freemon(Monitor *m)
 {
 	Monitor **mm = &monitors;
@@ -1051,11 +1416,14 @@ void freestatus(Status *s)
 
 	DETACH(s, ss);
 	if (!restart) {
+		epoll_ctl(epfd, EPOLL_CTL_DEL, fileno(s->file), NULL);
 		fclose(s->file);
 	}
 	if (s->path) {
 		free(s->path);
 	}
+	free(s->queue);
+	free(s->mon);
 	free(s);
 }
 
@@ -1080,10 +1448,25 @@ void freewm(void)
 	while (panels) unmanage(panels->win, 0);
 	while (desks) unmanage(desks->win, 0);
 	while (rules) freerule(rules);
+	while (conns) freeconn(conns);
 	while (stats) freestatus(stats);
 	while (monitors) freemon(monitors);
+	for (uint32_t i = 0; i < wintabsize; i++) {
+		while (wintab[i]) {
+			WinIdx *w = wintab[i];
+			wintab[i] = w->next;
+			free(w);
+		}
+	}
+	free(wintab);
 
 	xcb_key_symbols_free(keysyms);
+	for (uint32_t i = 0; i < LEN(borderpixmaps) && borderpixmaps[i].pmap; i++) {
+		xcb_free_pixmap(con, borderpixmaps[i].pmap);
+	}
+	for (uint32_t i = 0; i < LEN(bordergcs) && bordergcs[i].gc; i++) {
+		xcb_free_gc(con, bordergcs[i].gc);
+	}
 	for (uint32_t i = 0; i < LEN(cursors); i++) {
 		xcb_free_cursor(con, cursor[i]);
 	}
@@ -1121,6 +1504,7 @@ static void freews(Workspace *ws)
 		selmon->ws = selws;
 	}
 	DETACH(ws, wws);
+	free(ws->tiled);
 	free(ws);
 }
 
@@ -1209,11 +1593,11 @@ static void initatoms(xcb_atom_t *atoms, const char **names, int num)
 	}
 }
 
-static void initclient(xcb_window_t win, xcb_get_geometry_reply_t *g)
+static void initclient(xcb_window_t win, xcb_get_geometry_reply_t *g, Cookies *ck, xcb_atom_t type,
+					   xcb_window_t trans)
 {
 	Client *c, *term = NULL;
 	xcb_generic_error_t *e;
-	xcb_get_property_cookie_t pc;
 	xcb_get_property_reply_t *pr = NULL;
 
 	c = ecalloc(1, sizeof(Client));
@@ -1224,17 +1608,23 @@ static void initclient(xcb_window_t win, xcb_get_geometry_reply_t *g)
 	c->w = c->old_w = g->width;
 	c->h = c->old_h = g->height;
 	c->bw = c->old_bw = border[BORD_WIDTH];
-	c->pid = winpid(win);
+	c->sent.x = g->x;
+	c->sent.y = g->y;
+	c->sent.w = g->width;
+	c->sent.h = g->height;
+	c->sent.bw = g->border_width;
+	c->pid = pidreply(&ck->pid);
 	c->has_motif = 0;
 	c->state = STATE_NEEDSMAP;
 	c->old_state = STATE_NONE;
-	c->trans = wintoclient(wintrans(win));
-	winclass(win, c->clss, c->inst, sizeof(c->clss));
-	clientname(c);
+	c->trans = wintoclient(trans);
+	classreply(&ck->clss, c->clss, c->inst, sizeof(c->clss));
+	namereply(c, &ck->netname, &ck->wmname);
 	DBG("initclient: 0x%08x - %s", c->win, c->title)
 
-	pc = xcb_get_property(con, 0, c->win, wmatom[WM_MOTIF], wmatom[WM_MOTIF], 0, 5);
-	if ((pr = xcb_get_property_reply(con, pc, &e)) && xcb_get_property_value_length(pr) >= 3) {
+	pr = xcb_get_property_reply(con, ck->motif, &e);
+	ck->motif.sequence = 0;
+	if (pr && xcb_get_property_value_length(pr) >= 3) {
 		if (((xcb_atom_t *)xcb_get_property_value(pr))[2] == 0) {
 			c->has_motif = 1;
 			if (globalcfg[GLB_OBEY_MOTIF].val) {
@@ -1251,11 +1641,16 @@ static void initclient(xcb_window_t win, xcb_get_geometry_reply_t *g)
 	 * the new client is attached to the end of the stack, otherwise the head.
 	 * later in refresh(), focus(NULL) is called to focus the correct client */
 	DBG("initclient: rule setting: 0x%08x - %s", c->win, c->title)
-	clientrule(c, NULL, !globalcfg[GLB_FOCUS_OPEN].val);
-	clientstate(c); /* state MUST be after rule to ensure c->ws is set */
-	clienttype(c);
-	clienthints(c);
-	sizehints(c, 1);
+	matchrule(c, NULL, clientdesk(c, &ck->desk), type, !globalcfg[GLB_FOCUS_OPEN].val);
+	clientstate(c, &ck->state); /* state MUST be after rule to ensure c->ws is set */
+	if (type == netatom[NET_TYPE_DIALOG] || type == netatom[NET_TYPE_SPLASH] || c->trans) {
+		c->state |= STATE_FLOATING;
+	}
+	hintsreply(c, &ck->hints);
+	sizehintsreply(c, &ck->normal, 1);
+	if (syncbase >= 0) {
+		syncreply(c, &ck->sync, &ck->proto);
+	}
 	grabbuttons(c);
 	if (!c->trans) {
 		term = termforwin(c);
@@ -1290,9 +1685,25 @@ static void initclient(xcb_window_t win, xcb_get_geometry_reply_t *g)
 		cmdscratch(&arg);
 	}
 	wschange = c->ws->clients->next ? wschange : 1;
+	clichange = 1;
+}
+
+static Conn *initconn(int fd)
+{
+	Conn *cn;
+
+	fcntl(fd, F_SETFD, FD_CLOEXEC | fcntl(fd, F_GETFD));
+	if (watchfd(fd, EPOLLIN) == -1) {
+		warn("unable to watch command connection");
+		return NULL;
+	}
+	cn = ecalloc(1, sizeof(Conn));
+	cn->fd = fd;
+	ATTACH(cn, conns);
+	return cn;
 }
 
-static void initdesk(xcb_window_t win, xcb_get_geometry_reply_t *g)
+static void initdesk(xcb_window_t win, xcb_get_geometry_reply_t *g, Cookies *ck)
 {
 	Desk *d;
 	uint32_t deskmask = XCB_EVENT_MASK_PROPERTY_CHANGE | XCB_EVENT_MASK_STRUCTURE_NOTIFY;
@@ -1303,16 +1714,17 @@ static void initdesk(xcb_window_t win, xcb_get_geometry_reply_t *g)
 		d->mon = selws->mon;
 	}
 	d->state |= STATE_NEEDSMAP;
-	winclass(win, d->clss, d->inst, sizeof(d->clss));
+	classreply(&ck->clss, d->clss, d->inst, sizeof(d->clss));
 	DBG("initdesk: 0x%08x - %s", d->win, d->clss)
 	ATTACH(d, desks);
+	winindex(d->win, WIN_DESK, d);
 	MOVERESIZE(win, d->mon->x, d->mon->y, d->mon->w, d->mon->h, g->border_width);
 	setstackmode(d->win, XCB_STACK_MODE_BELOW);
 	xcb_change_window_attributes(con, d->win, XCB_CW_EVENT_MASK, &deskmask);
-	needsrefresh = 1;
+	setdirty(d->mon->ws, DIRTY_STACK);
 }
 
-static void initmon(int num, char *name, xcb_randr_output_t id, int x, int y, int w, int h)
+static Monitor *initmon(int num, char *name, xcb_randr_output_t id, int x, int y, int w, int h)
 {
 	Monitor *m, *tail;
 
@@ -1320,6 +1732,7 @@ static void initmon(int num, char *name, xcb_randr_output_t id, int x, int y, in
 	m->id = id;
 	m->num = num;
 	m->connected = 1;
+	m->rate = 60;
 	m->x = m->wx = x;
 	m->y = m->wy = y;
 	m->w = m->ww = w;
@@ -1331,9 +1744,10 @@ static void initmon(int num, char *name, xcb_randr_output_t id, int x, int y, in
 	} else {
 		monitors = m;
 	}
+	return m;
 }
 
-static void initpanel(xcb_window_t win, xcb_get_geometry_reply_t *g)
+static void initpanel(xcb_window_t win, xcb_get_geometry_reply_t *g, Cookies *ck)
 {
 	Panel *p;
 	uint32_t panelmask = XCB_EVENT_MASK_PROPERTY_CHANGE | XCB_EVENT_MASK_STRUCTURE_NOTIFY;
@@ -1348,12 +1762,13 @@ static void initpanel(xcb_window_t win, xcb_get_geometry_reply_t *g)
 	if (!(p->mon = coordtomon(g->x, g->y))) {
 		p->mon = selws->mon;
 	}
-	winclass(win, p->clss, p->inst, sizeof(p->clss));
+	classreply(&ck->clss, p->clss, p->inst, sizeof(p->clss));
 	ATTACH(p, panels);
+	winindex(p->win, WIN_PANEL, p);
 	fillstruts(p);
 	updstruts();
 	xcb_change_window_attributes(con, p->win, XCB_CW_EVENT_MASK, &panelmask);
-	needsrefresh = 1;
+	setdirty(p->mon->ws, DIRTY_STACK);
 }
 
 Rule *initrule(Rule *wr)
@@ -1425,11 +1840,13 @@ Status *initstatus(Status *tmp)
 	s->num = tmp->num;
 	s->file = tmp->file;
 	s->type = tmp->type;
-	switch (s->type) {
-		case STAT_WS: wschange = 1; break;
-		case STAT_WIN: winchange = 1; break;
-		case STAT_LYT: lytchange = 1; break;
-		default: wschange = 1; winchange = 1; lytchange = 1; break;
+	s->rate = tmp->rate;
+	s->fields = tmp->fields;
+	memcpy(s->ws, tmp->ws, sizeof(s->ws));
+	if (tmp->mon) {
+		size_t len = strlen(tmp->mon) + 1;
+		s->mon = ecalloc(1, len);
+		strlcpy(s->mon, tmp->mon, len);
 	}
 	TAIL(tail, stats);
 	if (tail) {
@@ -1437,6 +1854,17 @@ Status *initstatus(Status *tmp)
 	} else {
 		stats = s;
 	}
+	/* a reader that stops reading can't be allowed to block the wm, output
+	 * that doesn't fit is queued, see statuswrite() */
+	if (fileno(s->file) >= 0) {
+		fcntl(fileno(s->file), F_SETFL, O_NONBLOCK | fcntl(fileno(s->file), F_GETFL));
+	}
+	/* watched to notice the reader going away (hangup or error are always
+	 * reported) and when queued output can be sent, regular files can't be
+	 * polled and never block */
+	if (epfd >= 0 && fileno(s->file) >= 0 && watchfd(fileno(s->file), 0) == -1 && errno != EPERM) {
+		warn("unable to watch status file: %s", s->path ? s->path : "socket");
+	}
 	return s;
 }
 
@@ -1473,6 +1901,19 @@ static void initwm(void)
 	if (randrbase < 0 || !nextmon(monitors)) {
 		initmon(0, "default", 0, 0, 0, scr_w, scr_h);
 	}
+	if ((ext = xcb_get_extension_data(con, &xcb_sync_id)) && ext->present) {
+		xcb_generic_error_t *e;
+		xcb_sync_initialize_reply_t *sr;
+		xcb_sync_initialize_cookie_t sc = xcb_sync_initialize(con, XCB_SYNC_MAJOR_VERSION, XCB_SYNC_MINOR_VERSION);
+		if ((sr = xcb_sync_initialize_reply(con, sc, &e))) {
+			syncbase = ext->first_event;
+			free(sr);
+		} else {
+			iferr(0, "unable to initialize sync extension", e);
+		}
+	} else {
+		warnx("unable to get sync extension data, resizing won't wait on clients");
+	}
 
 	cws = winprop(root, netatom[NET_DESK_CUR], &r) && r < 100 ? r : 0;
 	updworkspaces(MAX(cws + 1, globalcfg[GLB_NUM_WS].val));
@@ -1500,6 +1941,51 @@ static void initwm(void)
 	numlockmask();
 }
 
+static void initwins(void)
+{
+	uint32_t n;
+	Cookies *ck;
+	xcb_window_t *w, *trans;
+	xcb_generic_error_t *e;
+	xcb_query_tree_reply_t *rt;
+
+	if (!(rt = xcb_query_tree_reply(con, xcb_query_tree(con, root), &e))) {
+		iferr(1, "unable to query tree from root window", e);
+	}
+	if (!(n = rt->children_len)) {
+		free(rt);
+		return;
+	}
+
+	/* request everything for every window before reading any of it back,
+	 * then adopt them all with a single refresh at the end rather than one
+	 * per window, transients go last so the window they belong to exists */
+	w = xcb_query_tree_children(rt);
+	ck = ecalloc(n, sizeof(Cookies));
+	trans = ecalloc(n, sizeof(xcb_window_t));
+	for (uint32_t i = 0; i < n; i++) {
+		wincookies(w[i], &ck[i]);
+	}
+	for (uint32_t i = 0; i < n; i++) {
+		trans[i] = transreply(&ck[i].trans);
+	}
+	for (uint32_t i = 0; i < n; i++) {
+		if (!trans[i]) {
+			adopt(w[i], &ck[i], XCB_WINDOW_NONE, 1);
+		}
+	}
+	for (uint32_t i = 0; i < n; i++) {
+		if (trans[i]) {
+			adopt(w[i], &ck[i], trans[i], 1);
+		}
+		freecookies(&ck[i]);
+	}
+	refresh();
+	free(trans);
+	free(ck);
+	free(rt);
+}
+
 static Workspace *initws(int num)
 {
 	Workspace *ws, *tail;
@@ -1546,82 +2032,145 @@ Workspace *itows(int num)
 	return ws;
 }
 
-void manage(xcb_window_t win, int scan)
+int loadcfg(FILE *errs)
 {
-	xcb_get_geometry_reply_t *g = NULL;
-	xcb_get_window_attributes_reply_t *wa = NULL;
-	xcb_atom_t type, state;
+	FILE *f, *resp;
+	ssize_t n;
+	static int loading = 0;
+	size_t len = 0, rlen = 0;
+	int lnum = 0, nerr = 0, usingresp = status_usingcmdresp;
+	char *cfg, *s, *msg, *line = NULL, *cmd = NULL, *out = NULL, path[PATH_MAX];
 
-	if (wintoclient(win) || wintopanel(win) || wintodesk(win)) {
-		return;
+	if (loading) {
+		return -1;
 	}
-	if (!(wa = winattr(win)) || !(g = wingeom(win))) {
-		goto end;
+	if (!(cfg = getenv("DKCONF"))) {
+		if (!(s = getenv("HOME"))) {
+			warn("getenv");
+			return -1;
+		}
+		strlcpy(path, s, sizeof(path));
+		strlcat(path, "/.config/dk/dk.conf", sizeof(path));
+		cfg = path;
 	}
-	DBG("manage: 0x%08x - %d,%d @ %dx%d", win, g->x, g->y, g->width, g->height)
-	if (winprop(win, netatom[NET_WM_TYPE], &type)) {
-		DBG("manage: 0x%08x has NET_WM_TYPE", win);
-		if (type == netatom[NET_TYPE_DOCK]) {
-			initpanel(win, g);
-		} else if (type == netatom[NET_TYPE_DESK]) {
-			initdesk(win, g);
-		} else if (!wa->override_redirect) {
-			goto client;
+	if (!(f = fopen(cfg, "r"))) {
+		if (errno != ENOENT) {
+			warn("unable to open config file: %s", cfg);
 		}
-		/* never reached for normal windows, only panels, desktops, and
-		 * override_redirect windows */
-		setwinstate(win, XCB_ICCCM_WM_STATE_NORMAL);
-	} else if (!wa->override_redirect) {
-client:
-		if (scan && !(wa->map_state == XCB_MAP_STATE_VIEWABLE ||
-					  (winprop(win, wmatom[WM_STATE], &state) && state == XCB_ICCCM_WM_STATE_ICONIC))) {
-			goto end;
+		return -1;
+	}
+
+	/* each line is run the same as a one-shot message from the socket, the
+	 * parser state is saved for when this is run from a reload command */
+	loading = 1;
+	resp = cmdresp;
+	while ((n = getline(&line, &len, f)) != -1) {
+		lnum++;
+		if (n && line[n - 1] == '\n') {
+			line[--n] = '\0';
+		}
+		/* a trailing backslash continues the command on the next line */
+		size_t clen = cmd ? strlen(cmd) : 0;
+		cmd = erealloc(cmd, clen + n + 2);
+		strlcpy(cmd + clen, line, n + 1);
+		if (n && line[n - 1] == '\\') {
+			cmd[clen + n - 1] = ' ';
+			continue;
+		}
+		for (s = cmd; *s == ' ' || *s == '\t'; s++)
+			;
+		if (*s && *s != '#') {
+			if (!(cmdresp = open_memstream(&out, &rlen))) {
+				warn("unable to open response stream");
+				break;
+			}
+			parsecmd(s);
+			if (status_usingcmdresp) {
+				/* there's nobody on the other end to read it */
+				Status *st;
+				TAIL(st, stats);
+				freestatus(st);
+				msg = "status requires a file when used in the config file";
+			} else {
+				fclose(cmdresp);
+				msg = out && *out == '!' ? out + 1 : NULL;
+			}
+			if (msg) {
+				if (errs) {
+					fprintf(errs, "%s:%d: %s\n", cfg, lnum, msg);
+				} else {
+					warnx("%s:%d: %s", cfg, lnum, msg);
+				}
+				nerr++;
+			}
+			free(out);
+			out = NULL;
 		}
-		initclient(win, g);
-		PROP(APPEND, root, netatom[NET_CLIENTS], XCB_ATOM_WINDOW, 32, 1, &win);
+		free(cmd);
+		cmd = NULL;
 	}
-	refresh();
-end:
-	free(wa);
-	free(g);
+	cmdresp = resp;
+	status_usingcmdresp = usingresp;
+	loading = 0;
+	free(cmd);
+	free(line);
+	fclose(f);
+	return nerr;
+}
+
+void manage(xcb_window_t win, int scan)
+{
+	Cookies ck;
+
+	if (wintoclient(win) || wintopanel(win) || wintodesk(win)) {
+		return;
+	}
+	wincookies(win, &ck);
+	if (adopt(win, &ck, transreply(&ck.trans), scan)) {
+		refresh();
+	}
+	freecookies(&ck);
 }
 
 void movestack(int direction)
 {
-	Client *c = cmdc, *t;
+	int i, n, p;
+	Client *c = cmdc, **cc;
+	Workspace *ws = c->ws;
 
-	if (!nexttiled(c->ws->clients->next)) {
+	if ((n = tilecount(ws)) < 2) {
 		return;
 	}
-	if (direction > 0) {
-		while (direction) {
-			detach(c, (t = nexttiled(c->next)) ? 0 : 1);
-			if (t) {
-				ATTACH(c, t->next);
-			}
-			direction--;
-		}
+	for (i = 0; i < n && ws->tiled[i] != c; i++)
+		;
+	if (i == n) {
+		return;
+	}
+	/* moving one position at a time wraps around the ends, so only the
+	 * final position matters, ws->tiled without c gives the neighbours */
+	memmove(&ws->tiled[i], &ws->tiled[i + 1], (n - i - 1) * sizeof(Client *));
+	n--;
+	p = ((i + direction) % (n + 1) + (n + 1)) % (n + 1);
+	cc = &ws->clients;
+	DETACH(c, cc);
+	if (!p) {
+		/* first tiled goes to the head of the list */
+		cc = &ws->clients;
+	} else if (direction > 0) {
+		/* after the tiled client it was moved past */
+		cc = &ws->tiled[p - 1]->next;
+	} else if (p == n) {
+		/* moved up past the first, wraps to the tail */
+		for (cc = &ws->clients; *cc; cc = &(*cc)->next)
+			;
 	} else {
-		int i;
-		while (direction) {
-			if (c == nexttiled(c->ws->clients)) {
-				detach(c, 0);
-				attach(c, 0);
-			} else {
-				for (t = nexttiled(c->ws->clients); t && nexttiled(t->next) && nexttiled(t->next) != c;
-					 t = nexttiled(t->next))
-					;
-				detach(c, (i = (t == nexttiled(c->ws->clients)) ? 1 : 0));
-				if (!i) {
-					c->next = t;
-					PREV(t, c->next, c->ws->clients);
-					t->next = c;
-				}
-			}
-			direction++;
-		}
+		/* directly before the tiled client it was moved past */
+		for (cc = &ws->clients; *cc != ws->tiled[p]; cc = &(*cc)->next)
+			;
 	}
-	needsrefresh = 1;
+	c->next = *cc;
+	*cc = c;
+	setdirty(ws, DIRTY_ALL);
 }
 
 Monitor *nextmon(Monitor *m)
@@ -1632,14 +2181,6 @@ Monitor *nextmon(Monitor *m)
 	return m;
 }
 
-Client *nexttiled(Client *c)
-{
-	while (c && FLOATING(c)) {
-		c = c->next;
-	}
-	return c;
-}
-
 void numlockmask(void)
 {
 	xcb_generic_error_t *e;
@@ -1738,43 +2279,148 @@ void quadrant(Client *c, int *x, int *y, const int *w, const int *h)
 	*y = CLAMP(*y, m->wy, m->wy + m->wh - (*h + (2 * c->bw)));
 }
 
+static void readconn(Conn *cn)
+{
+	ssize_t n;
+	char *end, *line, *nl, c;
+	static const char start[] = "session\n";
+
+	/* the buffer doubles as needed, messages have no size limit */
+	if (cn->size - cn->len < PIPE_BUF) {
+		cn->buf = erealloc(cn->buf, (cn->size = MAX(cn->size * 2, PIPE_BUF)));
+	}
+	if ((n = recv(cn->fd, cn->buf + cn->len, cn->size - cn->len - 1, 0)) <= 0) {
+		/* the rest of the session is run before closing, including
+		 * an unterminated last line, same for a one-shot message */
+		cn->eof = 1;
+		epoll_ctl(epfd, EPOLL_CTL_DEL, cn->fd, NULL);
+		if (cn->session && cn->len && cn->buf[cn->len - 1] != '\n') {
+			cn->buf[cn->len++] = '\n';
+		}
+		cn->buf[cn->len] = '\0';
+		if (cn->session) {
+			return;
+		} else if (!cn->len) {
+			freeconn(cn);
+			return;
+		}
+	} else {
+		cn->len += n;
+		cn->buf[cn->len] = '\0';
+	}
+
+	if (!cn->session) {
+		if (!cn->eof && cn->len < sizeof(start) - 1 && !strncmp(cn->buf, start, cn->len)) {
+			return; /* could still be a session start, wait for the rest */
+		}
+		if (strncmp(cn->buf, start, sizeof(start) - 1)) {
+			/* a one-shot message ends with a null byte or when the sender
+			 * stops writing, older clients that send neither are taken as
+			 * done once a newline is the last thing available */
+			if ((end = memchr(cn->buf, '\0', cn->len))) {
+				cn->len = end - cn->buf;
+			} else if (!cn->eof && (cn->buf[cn->len - 1] != '\n' ||
+									recv(cn->fd, &c, 1, MSG_PEEK | MSG_DONTWAIT) != -1)) {
+				return;
+			}
+			/* the response stream owns the fd from here and is either
+			 * closed below or handed to a status subscriber */
+			if (cn->len && cn->buf[cn->len - 1] == '\n') {
+				cn->buf[--cn->len] = '\0';
+			}
+			if (!(cmdresp = fdopen(cn->fd, "w"))) {
+				warn("unable to open the socket as file: %s", sock);
+				freeconn(cn);
+				return;
+			}
+			/* one command per line the same as the config file, blank
+			 * lines and comments are skipped, a status ends the message */
+			status_usingcmdresp = 0;
+			for (line = cn->buf; line && !status_usingcmdresp; line = nl) {
+				if ((nl = strchr(line, '\n'))) {
+					*nl++ = '\0';
+				}
+				while (*line == ' ' || *line == '\t') {
+					line++;
+				}
+				if (*line && *line != '#') {
+					parsecmd(line);
+				}
+			}
+			if (!status_usingcmdresp) {
+				fclose(cmdresp);
+			}
+			cmdresp = NULL;
+			cn->fd = -1;
+			freeconn(cn);
+			return;
+		}
+		if (!(cn->resp = fdopen(cn->fd, "w"))) {
+			warn("unable to open the socket as file: %s", sock);
+			freeconn(cn);
+			return;
+		}
+		cn->session = 1;
+		memmove(cn->buf, cn->buf + sizeof(start) - 1, (cn->len -= sizeof(start) - 1) + 1);
+	}
+}
+
 void refresh(void)
 {
 	Desk *d;
 	Panel *p;
 	Client *c;
 	Monitor *m;
+	Workspace *ws;
 	int x, y, w, h;
+	uint32_t dirty, refocus = 0;
+	static Workspace *focusws;
 
 	for (m = monitors; m; m = m->next) {
-		DBG("refresh: workspace: %d, monitor: %s layout: %s", m->ws->num + 1, m->name, m->ws->layout->name)
-		if (m->ws->layout->func && m->ws->layout->func(m->ws) < 0) {
-			m->ws->layout->func(m->ws);
-		}
-		for (c = m->ws->clients; c; c = c->next) {
-			if (FULLSCREEN(c)) {
-				resize(c, m->x, m->y, m->w, m->h, 0);
-			} else if (FLOATING(c)) {
-				resizehint(c, (x = c->x), (y = c->y), (w = c->w), (h = c->h), c->bw, 0, 0);
+		ws = m->ws;
+		dirty = ws->dirty;
+		if (m->shown != ws) {
+			/* a different workspace is on the monitor, nothing done for
+			 * the last one applies here */
+			dirty = DIRTY_ALL;
+			m->shown = ws;
+		}
+		ws->dirty = 0;
+		if (ws == selws) {
+			refocus = dirty & DIRTY_FOCUS;
+		}
+		if (dirty & DIRTY_LAYOUT) {
+			DBG("refresh: workspace: %d, monitor: %s layout: %s", ws->num + 1, m->name, ws->layout->name)
+			layoutws(ws);
+			for (c = ws->clients; c; c = c->next) {
+				if (FULLSCREEN(c)) {
+					resize(c, m->x, m->y, m->w, m->h, 0);
+				} else if (FLOATING(c)) {
+					resizehint(c, (x = c->x), (y = c->y), (w = c->w), (h = c->h), c->bw, 0, 0);
+				}
 			}
+		}
+		for (c = ws->clients; c; c = c->next) {
 			/* map last to avoid resizing while visible */
 			winmap(c->win, &c->state);
 		}
-		for (p = panels; p; p = p->next) {
-			if (p->mon == m) {
-				setstackmode(p->win, XCB_STACK_MODE_BELOW);
+		if (dirty & DIRTY_STACK) {
+			for (p = panels; p; p = p->next) {
+				if (p->mon == m) {
+					setstackmode(p->win, XCB_STACK_MODE_BELOW);
+				}
 			}
-		}
-		for (c = m->ws->stack; c; c = c->snext) {
-			if (!FLOATING(c)) {
-				setstackmode(c->win, XCB_STACK_MODE_BELOW);
-			} else if (STATE(c, ABOVE)) {
-				setstackmode(c->win, XCB_STACK_MODE_ABOVE);
+			for (c = ws->stack; c; c = c->snext) {
+				if (!FLOATING(c)) {
+					setstackmode(c->win, XCB_STACK_MODE_BELOW);
+				} else if (STATE(c, ABOVE)) {
+					setstackmode(c->win, XCB_STACK_MODE_ABOVE);
+				}
 			}
-		}
-		for (d = desks; d; d = d->next) {
-			if (d->mon == m) {
-				setstackmode(d->win, XCB_STACK_MODE_BELOW);
+			for (d = desks; d; d = d->next) {
+				if (d->mon == m) {
+					setstackmode(d->win, XCB_STACK_MODE_BELOW);
+				}
 			}
 		}
 	}
@@ -1785,12 +2431,14 @@ void refresh(void)
 		winmap(d->win, &d->state);
 	}
 
-	focus(NULL);
-	if (selws->sel && FLOATING(selws->sel)) {
-		setstackmode(selws->sel->win, XCB_STACK_MODE_ABOVE);
+	if (refocus || focusws != selws) {
+		focusws = selws;
+		focus(NULL);
+		if (selws->sel && FLOATING(selws->sel)) {
+			setstackmode(selws->sel->win, XCB_STACK_MODE_ABOVE);
+		}
 	}
 	ignore(XCB_ENTER_NOTIFY);
-	xcb_aux_sync(con);
 	needsrefresh = 0;
 }
 
@@ -1857,16 +2505,23 @@ static void relocatews(Workspace *ws, Monitor *old, int wasvis)
 	}
 }
 
-void resize(Client *c, int x, int y, int w, int h, int bw)
+int resize(Client *c, int x, int y, int w, int h, int bw)
 {
+	int changed;
+
 	if (FLOATING(c) && !FULLSCREEN(c)) {
 		c->old_x = c->x, c->old_y = c->y, c->old_w = c->w, c->old_h = c->h;
 	}
 	c->x = x, c->y = y, c->w = w, c->h = h;
-	MOVERESIZE(c->win, x, y, w, h, bw);
+	changed = clientgeom(c, x, y, w, h, bw);
 	clientborder(c, c == selws->sel);
-	sendconfigure(c);
+	if (changed) {
+		sendconfigure(c);
+	} else {
+		reqelided++;
+	}
 	xcb_flush(con);
+	return changed;
 }
 
 void resizehint(Client *c, int x, int y, int w, int h, int bw, int usermotion, int mouse)
@@ -1883,6 +2538,46 @@ static int rulecmp(Client *c, Rule *r)
 			 (r->title && regexec(&(r->titlereg), c->title, 0, NULL, 0)));
 }
 
+static int runconn(Conn *cn)
+{
+	int n = 0;
+	char *line, *nl;
+
+	/* each complete line is one command and gets exactly one response,
+	 * responses are terminated by a null byte so empty ones still count */
+	for (line = cn->buf; n < globalcfg[GLB_CMD_BATCH].val && (nl = strchr(line, '\n')); line = nl + 1, n++) {
+		*nl = '\0';
+		cmdresp = cn->resp;
+		parsecmd(line);
+		cmdresp = NULL;
+		if (status_usingcmdresp) {
+			/* the rest of the session is a status stream, each message
+			 * still gets a null byte so the framing stays the same */
+			Status *s;
+			TAIL(s, stats);
+			if (s && s->file == cn->resp) {
+				framestatus(s);
+			} else {
+				fputc('\0', cn->resp);
+				fflush(cn->resp);
+			}
+			cn->resp = NULL;
+			cn->fd = -1;
+			freeconn(cn);
+			return 0;
+		}
+		fputc('\0', cn->resp);
+		fflush(cn->resp);
+	}
+	memmove(cn->buf, line, (cn->len -= line - cn->buf) + 1);
+	if (strchr(cn->buf, '\n')) {
+		return 1;
+	} else if (cn->eof) {
+		freeconn(cn);
+	}
+	return 0;
+}
+
 void sendconfigure(Client *c)
 {
 	xcb_configure_notify_event_t e = {
@@ -1932,6 +2627,19 @@ int sendwmproto(Client *c, xcb_atom_t proto)
 	return exists;
 }
 
+void setdirty(Workspace *ws, uint32_t flags)
+{
+	/* NULL marks every workspace, for changes to global settings */
+	if (ws) {
+		ws->dirty |= flags;
+	} else {
+		for (ws = workspaces; ws; ws = ws->next) {
+			ws->dirty |= flags;
+		}
+	}
+	needsrefresh = 1;
+}
+
 void setfullscreen(Client *c, int fullscreen)
 {
 	Monitor *m;
@@ -1947,6 +2655,7 @@ void setfullscreen(Client *c, int fullscreen)
 		if (c->bw || (c->state == STATE_NOBORDER))
 			c->old_bw = c->bw;
 		c->bw = 0;
+		setdirty(c->ws, DIRTY_ALL);
 		if (VISIBLE(c)) {
 			resize(c, m->x, m->y, m->w, m->h, 0);
 			setstackmode(c->win, XCB_STACK_MODE_ABOVE);
@@ -1956,6 +2665,7 @@ void setfullscreen(Client *c, int fullscreen)
 		setnetstate(c->win, 0);
 		c->state = c->old_state;
 		c->bw = c->old_bw;
+		setdirty(c->ws, DIRTY_ALL);
 		if (VISIBLE(c)) {
 			resizehint(c, c->old_x, c->old_y, c->old_w, c->old_h, c->bw, 0, 0);
 			refresh();
@@ -2061,6 +2771,7 @@ void setworkspace(Client *c, Workspace *ws, int stacktail)
 		attachstack(c);
 	}
 	wschange = c->ws->clients->next ? wschange : 1;
+	clichange = 1;
 }
 
 void showhide(Client *c)
@@ -2073,11 +2784,11 @@ void showhide(Client *c)
 		DBG("showhide: ws: %d - showing window: 0x%08x %s", c->ws->num + 1, c->win, c->title)
 		setwinstate(c->win, XCB_ICCCM_WM_STATE_NORMAL);
 		if (FULLSCREEN(c)) {
-			MOVERESIZE(c->win, m->x, m->y, m->w, m->h, 0);
+			clientgeom(c, m->x, m->y, m->w, m->h, 0);
 		} else if (FLOATING(c)) {
 			resize(c, c->x, c->y, c->w, c->h, c->bw);
 		} else if (c == c->ws->sel || c->ws->layout->func != mono) {
-			MOVE(c->win, c->x, c->y);
+			clientmove(c, c->x, c->y);
 		}
 		showhide(c->snext);
 	} else {
@@ -2085,7 +2796,7 @@ void showhide(Client *c)
 		if (!STATE(c, STICKY)) {
 			DBG("showhide: ws: %d - hiding window: 0x%08x %s", c->ws->num + 1, c->win, c->title)
 			setwinstate(c->win, XCB_ICCCM_WM_STATE_ICONIC);
-			MOVE(c->win, W(c) * -2, c->y);
+			clientmove(c, W(c) * -2, c->y);
 		} else if (c->ws != selws && MON(c) == selws->mon) {
 			DBG("showhide: ws: %d -- not hiding sticky window: 0x%08x %s", c->ws->num + 1, c->win, c->title)
 			Client *sel = lastws->sel == c ? c : selws->sel;
@@ -2107,17 +2818,22 @@ void sighandle(int sig)
 }
 
 void sizehints(Client *c, int uss)
+{
+	xcb_get_property_cookie_t pc = xcb_icccm_get_wm_normal_hints(con, c->win);
+
+	sizehintsreply(c, &pc, uss);
+}
+
+static void sizehintsreply(Client *c, xcb_get_property_cookie_t *pc, int uss)
 {
 	xcb_size_hints_t s;
 	xcb_generic_error_t *e;
-	xcb_get_property_cookie_t pc;
 
 	DBG("sizehints: client: 0x%08x %s", c->win, c->title)
-	pc = xcb_icccm_get_wm_normal_hints(con, c->win);
 	c->inc_w = c->inc_h = 0;
 	c->max_aspect = c->min_aspect = 0.0;
 	c->min_w = c->min_h = c->max_w = c->max_h = c->base_w = c->base_h = 0;
-	if (xcb_icccm_get_wm_normal_hints_reply(con, pc, &s, &e)) {
+	if (xcb_icccm_get_wm_normal_hints_reply(con, *pc, &s, &e)) {
 		if (uss && s.flags & XCB_ICCCM_SIZE_HINT_US_SIZE) {
 			c->w = s.width, c->h = s.height;
 		}
@@ -2147,6 +2863,7 @@ void sizehints(Client *c, int uss)
 	} else {
 		iferr(0, "unable to get wm normal hints", e);
 	}
+	pc->sequence = 0;
 	DBG("sizehints: client: 0x%08x %s -- max_w = %d, max_h = %d, min_w = %d, min_h = %d", c->win, c->title,
 		c->max_w, c->max_h, c->min_w, c->min_h)
 	if (c->max_w && c->max_w == c->min_w && c->max_h && c->max_h == c->min_h) {
@@ -2156,6 +2873,82 @@ void sizehints(Client *c, int uss)
 	c->hints = 1;
 }
 
+static void syncfree(Client *c)
+{
+	if (c->sync.alarm) {
+		xcb_sync_destroy_alarm(con, c->sync.alarm);
+		c->sync.alarm = 0;
+	}
+	if (c->sync.waiting) {
+		c->sync.waiting = 0;
+		syncwaiting--;
+	}
+	c->sync.counter = XCB_NONE;
+}
+
+static void syncreply(Client *c, xcb_get_property_cookie_t *pc, xcb_get_property_cookie_t *rc)
+{
+	int listed = 0;
+	xcb_atom_t counter;
+	xcb_generic_error_t *e;
+	xcb_icccm_get_wm_protocols_reply_t p;
+
+	/* the counter is only used when the client also lists the protocol,
+	 * otherwise it may never be updated and every resize would stall */
+	syncfree(c);
+	if (xcb_icccm_get_wm_protocols_reply(con, *rc, &p, &e)) {
+		for (uint32_t i = 0; !listed && i < p.atoms_len; i++) {
+			listed = p.atoms[i] == netatom[NET_WM_SYNC];
+		}
+		xcb_icccm_get_wm_protocols_reply_wipe(&p);
+	} else {
+		iferr(0, "unable to get wm protocols reply", e);
+	}
+	rc->sequence = 0;
+	if (propreply(pc, &counter) && listed) {
+		c->sync.counter = counter;
+	}
+}
+
+static void syncrequest(Client *c)
+{
+	uint32_t v[8];
+	uint64_t val = ++c->sync.value;
+
+	/* the alarm fires once the client has drawn at the new size and set its
+	 * counter to the value we send, it's made lazily since a new alarm
+	 * compared against a counter value of 0 would fire immediately */
+	if (!c->sync.alarm) {
+		c->sync.alarm = xcb_generate_id(con);
+		v[0] = c->sync.counter;
+		v[1] = XCB_SYNC_VALUETYPE_ABSOLUTE;
+		v[2] = val >> 32, v[3] = val & 0xffffffff;
+		v[4] = XCB_SYNC_TESTTYPE_POSITIVE_COMPARISON;
+		v[5] = v[6] = 0;
+		v[7] = 1;
+		xcb_sync_create_alarm(con, c->sync.alarm,
+							  XCB_SYNC_CA_COUNTER | XCB_SYNC_CA_VALUE_TYPE | XCB_SYNC_CA_VALUE |
+								  XCB_SYNC_CA_TEST_TYPE | XCB_SYNC_CA_DELTA | XCB_SYNC_CA_EVENTS,
+							  v);
+	} else {
+		v[0] = val >> 32, v[1] = val & 0xffffffff;
+		xcb_sync_change_alarm(con, c->sync.alarm, XCB_SYNC_CA_VALUE, v);
+	}
+	xcb_client_message_event_t e = {.response_type = XCB_CLIENT_MESSAGE,
+									.window = c->win,
+									.type = wmatom[WM_PROTO],
+									.format = 32,
+									.data.data32[0] = netatom[NET_WM_SYNC],
+									.data.data32[1] = XCB_TIME_CURRENT_TIME,
+									.data.data32[2] = val & 0xffffffff,
+									.data.data32[3] = val >> 32};
+	xcb_send_event(con, 0, c->win, XCB_EVENT_MASK_NO_EVENT, (char *)&e);
+	if (!c->sync.waiting) {
+		c->sync.waiting = 1;
+		syncwaiting++;
+	}
+}
+
 static Client *termforwin(const Client *w)
 {
 	Client *c;
@@ -2179,16 +2972,6 @@ static Client *termforwin(const Client *w)
 	return NULL;
 }
 
-int tilecount(Workspace *ws)
-{
-	int i;
-	Client *c;
-
-	for (i = 0, c = nexttiled(ws->clients); c; c = nexttiled(c->next), i++)
-		;
-	return i;
-}
-
 void unfocus(Client *c, int focusroot)
 {
 	if (c) {
@@ -2221,6 +3004,7 @@ void unmanage(xcb_window_t win, int destroyed)
 			return;
 		}
 		if ((s = absorbingclient(c->win))) {
+			syncfree(s->absorbed);
 			free(s->absorbed);
 			s->absorbed = NULL;
 			if (running) {
@@ -2231,13 +3015,17 @@ void unmanage(xcb_window_t win, int destroyed)
 		if (c->cb && running) {
 			c->cb->func(c, 1);
 		}
+		syncfree(c);
 		wschange = c->ws->clients->next ? wschange : 1;
+		clichange = 1;
 		detach(c, 0);
 		detachstack(c);
+		winunindex(c->win);
 	} else if ((ptr = p = wintopanel(win))) {
 		DBG("unmanage: panel: 0x%08x %s", p->win, p->clss)
 		Panel **pp = &panels;
 		DETACH(p, pp);
+		winunindex(p->win);
 		if (running) {
 			updstruts();
 		}
@@ -2245,6 +3033,7 @@ void unmanage(xcb_window_t win, int destroyed)
 		DBG("unmanage: desktop: 0x%08x %s", d->win, d->clss)
 		Desk **dd = &desks;
 		DETACH(d, dd);
+		winunindex(d->win);
 	}
 
 	if (!destroyed) {
@@ -2259,7 +3048,6 @@ void unmanage(xcb_window_t win, int destroyed)
 			}
 		}
 		setwinstate(win, XCB_ICCCM_WM_STATE_WITHDRAWN);
-		xcb_aux_sync(con);
 		xcb_ungrab_server(con);
 	} else {
 		DBG("unmanage: 0x%08x was destroyed", win)
@@ -2320,7 +3108,31 @@ static void updnetworkspaces(void)
 	}
 }
 
-static int updoutputs(xcb_randr_output_t *outs, int nouts, xcb_timestamp_t t)
+static int moderate(xcb_randr_mode_info_t *modes, int nmodes, xcb_randr_mode_t id)
+{
+	uint32_t vtotal;
+
+	for (int i = 0; i < nmodes; i++) {
+		if (modes[i].id != id) {
+			continue;
+		}
+		vtotal = modes[i].vtotal;
+		if (modes[i].mode_flags & XCB_RANDR_MODE_FLAG_DOUBLE_SCAN) {
+			vtotal *= 2;
+		}
+		if (modes[i].mode_flags & XCB_RANDR_MODE_FLAG_INTERLACE) {
+			vtotal /= 2;
+		}
+		if (modes[i].htotal && vtotal) {
+			return (modes[i].dot_clock + (modes[i].htotal * vtotal) / 2) / (modes[i].htotal * vtotal);
+		}
+		break;
+	}
+	return 60;
+}
+
+static int updoutputs(xcb_randr_output_t *outs, int nouts, xcb_randr_mode_info_t *modes, int nmodes,
+					  xcb_timestamp_t t)
 {
 	Desk *d;
 	Monitor *m;
@@ -2369,9 +3181,10 @@ static int updoutputs(xcb_randr_output_t *outs, int nouts, xcb_timestamp_t t)
 				m->h = m->wh = crtc->height;
 				m->connected = (m->w != 0 && m->h != 0 && crtc->mode != XCB_NONE);
 			} else {
-				initmon(nmons++, name, outs[i], crtc->x, crtc->y, crtc->width, crtc->height);
+				m = initmon(nmons++, name, outs[i], crtc->x, crtc->y, crtc->width, crtc->height);
 				changed = 1;
 			}
+			m->rate = moderate(modes, nmodes, crtc->mode);
 			DBG("updoutputs: %s - %d,%d @ %dx%d - changed: %d", name, crtc->x, crtc->y, crtc->width,
 				crtc->height, changed)
 next:
@@ -2422,7 +3235,9 @@ int updrandr(int init)
 		if ((n = xcb_randr_get_screen_resources_outputs_length(r)) <= 0) {
 			warnx("no monitors available");
 		} else {
-			changed = updoutputs(xcb_randr_get_screen_resources_outputs(r), n, r->config_timestamp);
+			changed = updoutputs(xcb_randr_get_screen_resources_outputs(r), n,
+								 xcb_randr_get_screen_resources_modes(r),
+								 xcb_randr_get_screen_resources_modes_length(r), r->config_timestamp);
 		}
 		if (!init) {
 			uint32_t rm = monitors->next ? (rootmask | XCB_EVENT_MASK_POINTER_MOTION) : rootmask;
@@ -2439,33 +3254,41 @@ void updstruts(void)
 {
 	Panel *p;
 	Monitor *m;
+	int wx, wy, ww, wh;
 
 	for (m = monitors; m; m = m->next) {
-		m->wx = m->x, m->wy = m->y, m->ww = m->w, m->wh = m->h;
-	}
-	for (p = panels; p; p = p->next) {
-		if (p->l || p->r || p->t || p->b) {
+		wx = m->x, wy = m->y, ww = m->w, wh = m->h;
+		for (p = panels; p; p = p->next) {
+			if (p->mon != m || !(p->l || p->r || p->t || p->b)) {
+				continue;
+			}
 			/* adjust the struts if they don't match up with the panel size and location */
-			if (p->l && p->l > p->w && p->x == p->mon->x) {
+			if (p->l && p->l > p->w && p->x == m->x) {
 				p->l = p->w;
 			}
-			if (p->r && p->r > p->w && p->x + p->w == p->mon->x + p->mon->w) {
+			if (p->r && p->r > p->w && p->x + p->w == m->x + m->w) {
 				p->r = p->w;
 			}
-			if (p->t && p->t > p->h && p->y == p->mon->y) {
+			if (p->t && p->t > p->h && p->y == m->y) {
 				p->t = p->h;
 			}
-			if (p->b && p->b > p->h && p->y + p->h == p->mon->y + p->mon->h) {
+			if (p->b && p->b > p->h && p->y + p->h == m->y + m->h) {
 				p->b = p->h;
 			}
-			p->mon->wx += p->l;
-			p->mon->wy += p->t;
-			p->mon->ww -= p->r + p->l;
-			p->mon->wh -= p->b + p->t;
+			wx += p->l;
+			wy += p->t;
+			ww -= p->r + p->l;
+			wh -= p->b + p->t;
+		}
+		/* only the monitors whose work area moved need a new layout */
+		if (wx != m->wx || wy != m->wy || ww != m->ww || wh != m->wh) {
+			m->wx = wx, m->wy = wy, m->ww = ww, m->wh = wh;
+			if (m->ws) {
+				setdirty(m->ws, DIRTY_ALL);
+			}
 		}
 	}
 	updnetworkspaces();
-	needsrefresh = 1;
 }
 
 void updworkspaces(int needed)
@@ -2497,38 +3320,45 @@ void updworkspaces(int needed)
 	updstruts();
 	setnetwsnames();
 	wschange = 1;
-	needsrefresh = 1;
+	setdirty(NULL, DIRTY_ALL);
 }
 
-static xcb_get_window_attributes_reply_t *winattr(xcb_window_t win)
+static int watchfd(int fd, uint32_t events)
 {
-	xcb_generic_error_t *e;
-	xcb_get_window_attributes_reply_t *wa = NULL;
+	struct epoll_event ev = {.events = events, .data.fd = fd};
 
-	if (win == XCB_WINDOW_NONE) {
-		return wa;
-	}
-	if (!(wa = xcb_get_window_attributes_reply(con, xcb_get_window_attributes(con, win), &e))) {
-		iferr(0, "unable to get window geometry reply", e);
+	if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+		if (errno != EEXIST) {
+			return -1;
+		}
+		return epoll_ctl(epfd, EPOLL_CTL_MOD, fd, &ev);
 	}
-	return wa;
+	return 0;
 }
 
-static void winclass(xcb_window_t win, char *clss, char *inst, size_t len)
+static void wincookies(xcb_window_t win, Cookies *ck)
 {
-	/* it is assumed that class and inst are allocated and the same size */
-	xcb_generic_error_t *e;
-	xcb_icccm_get_wm_class_reply_t p;
+	xcb_res_client_id_spec_t spec = {
+		.client = win,
+		.mask = XCB_RES_CLIENT_ID_MASK_LOCAL_CLIENT_PID,
+	};
 
-	if (!xcb_icccm_get_wm_class_reply(con, xcb_icccm_get_wm_class(con, win), &p, &e)) {
-		iferr(0, "unable to get window class", e);
-		strlcpy(clss, "broken", len);
-		strlcpy(inst, "broken", len);
-	} else {
-		strlcpy(clss, strlen(p.class_name) ? p.class_name : "broken", len);
-		strlcpy(inst, strlen(p.instance_name) ? p.instance_name : "broken", len);
-		xcb_icccm_get_wm_class_reply_wipe(&p);
-	}
+	ck->attr = xcb_get_window_attributes(con, win);
+	ck->geom = xcb_get_geometry(con, win);
+	ck->type = xcb_get_property(con, 0, win, netatom[NET_WM_TYPE], XCB_ATOM_ANY, 0, 1);
+	ck->wmstate = xcb_get_property(con, 0, win, wmatom[WM_STATE], XCB_ATOM_ANY, 0, 1);
+	ck->desk = xcb_get_property(con, 0, win, netatom[NET_WM_DESK], XCB_ATOM_ANY, 0, 1);
+	ck->state = xcb_get_property(con, 0, win, netatom[NET_WM_STATE], XCB_ATOM_ANY, 0, 3);
+	ck->motif = xcb_get_property(con, 0, win, wmatom[WM_MOTIF], wmatom[WM_MOTIF], 0, 5);
+	ck->netname = xcb_icccm_get_text_property(con, win, netatom[NET_WM_NAME]);
+	ck->wmname = xcb_icccm_get_text_property(con, win, XCB_ATOM_WM_NAME);
+	ck->clss = xcb_icccm_get_wm_class(con, win);
+	ck->trans = xcb_icccm_get_wm_transient_for(con, win);
+	ck->hints = xcb_icccm_get_wm_hints(con, win);
+	ck->normal = xcb_icccm_get_wm_normal_hints(con, win);
+	ck->sync = xcb_get_property(con, 0, win, netatom[NET_WM_SYNCCTR], XCB_ATOM_CARDINAL, 0, 1);
+	ck->proto = xcb_icccm_get_wm_protocols(con, win, wmatom[WM_PROTO]);
+	ck->pid = xcb_res_query_client_ids(con, 1, &spec);
 }
 
 static xcb_get_geometry_reply_t *wingeom(xcb_window_t win)
@@ -2545,6 +3375,63 @@ static xcb_get_geometry_reply_t *wingeom(xcb_window_t win)
 	return g;
 }
 
+static uint32_t winhash(xcb_window_t win, uint32_t size)
+{
+	/* resource ids share their high bits per client, fold them in before masking */
+	return ((win >> 16) ^ win) & (size - 1);
+}
+
+static void winindex(xcb_window_t win, int type, void *ptr)
+{
+	WinIdx *w, **tab;
+	uint32_t h, size;
+
+	if (wintabsize) {
+		for (w = wintab[winhash(win, wintabsize)]; w; w = w->next) {
+			if (w->win == win) {
+				w->type = type;
+				w->ptr = ptr;
+				return;
+			}
+		}
+	}
+	if (wintabcount >= wintabsize) {
+		size = wintabsize ? wintabsize * 2 : 64;
+		tab = ecalloc(size, sizeof(WinIdx *));
+		for (uint32_t i = 0; i < wintabsize; i++) {
+			while ((w = wintab[i])) {
+				wintab[i] = w->next;
+				h = winhash(w->win, size);
+				w->next = tab[h];
+				tab[h] = w;
+			}
+		}
+		free(wintab);
+		wintab = tab;
+		wintabsize = size;
+	}
+	w = ecalloc(1, sizeof(WinIdx));
+	w->win = win;
+	w->type = type;
+	w->ptr = ptr;
+	h = winhash(win, wintabsize);
+	w->next = wintab[h];
+	wintab[h] = w;
+	wintabcount++;
+}
+
+static void *winlookup(xcb_window_t win, int type)
+{
+	if (wintabsize && win != XCB_WINDOW_NONE && win != root) {
+		for (WinIdx *w = wintab[winhash(win, wintabsize)]; w; w = w->next) {
+			if (w->win == win) {
+				return w->type == type ? w->ptr : NULL;
+			}
+		}
+	}
+	return NULL;
+}
+
 void winmap(xcb_window_t win, uint32_t *state)
 {
 	if ((*state & STATE_NEEDSMAP)) {
@@ -2552,22 +3439,19 @@ void winmap(xcb_window_t win, uint32_t *state)
 		setwinstate(win, XCB_ICCCM_WM_STATE_NORMAL);
 		xcb_map_window(con, win);
 		*state &= ~STATE_NEEDSMAP;
-		xcb_aux_sync(con);
 	}
 }
 
-pid_t winpid(xcb_window_t win)
+static pid_t pidreply(xcb_res_query_client_ids_cookie_t *rc)
 {
 	pid_t result = 0;
 	xcb_generic_error_t *e = NULL;
 	xcb_res_query_client_ids_reply_t *r;
 	xcb_res_client_id_value_iterator_t i;
-	xcb_res_client_id_spec_t spec = {
-		.client = win,
-		.mask = XCB_RES_CLIENT_ID_MASK_LOCAL_CLIENT_PID,
-	};
 
-	if (!(r = xcb_res_query_client_ids_reply(con, xcb_res_query_client_ids(con, 1, &spec), &e))) {
+	r = xcb_res_query_client_ids_reply(con, *rc, &e);
+	rc->sequence = 0;
+	if (!r) {
 		iferr(0, "unable to get client ids", e);
 		return 0;
 	}
@@ -2584,95 +3468,96 @@ pid_t winpid(xcb_window_t win)
 
 static int winprop(xcb_window_t win, xcb_atom_t prop, xcb_atom_t *ret)
 {
+	xcb_get_property_cookie_t pc = xcb_get_property(con, 0, win, prop, XCB_ATOM_ANY, 0, 1);
+
+	return propreply(&pc, ret);
+}
+
+static int propreply(xcb_get_property_cookie_t *pc, xcb_atom_t *ret)
+{
+	int found = 0;
 	xcb_generic_error_t *e;
-	xcb_get_property_cookie_t c;
 	xcb_get_property_reply_t *r = NULL;
 
-	c = xcb_get_property(con, 0, win, prop, XCB_ATOM_ANY, 0, 1);
-	if ((r = xcb_get_property_reply(con, c, &e)) && r->value_len) {
+	if ((r = xcb_get_property_reply(con, *pc, &e)) && r->value_len) {
 		*ret = *(xcb_atom_t *)xcb_get_property_value(r);
-		free(r);
-		return 1;
+		found = 1;
 	} else {
 		iferr(0, "unable to get window property reply", e);
 	}
 	free(r);
-	return 0;
+	pc->sequence = 0;
+	return found;
 }
 
 Client *wintoclient(xcb_window_t win)
 {
-	Client *c;
-	Workspace *ws;
-
-	if (win != XCB_WINDOW_NONE && win != root) {
-		for (ws = workspaces; ws; ws = ws->next) {
-			for (c = ws->clients; c; c = c->next) {
-				if (c->win == win) {
-					return c;
-				}
-			}
-		}
-		for (c = scratch.clients; c; c = c->next) {
-			if (c->win == win) {
-				return c;
-			}
-		}
-	}
-	return NULL;
+	return winlookup(win, WIN_CLIENT);
 }
 
 Desk *wintodesk(xcb_window_t win)
 {
-	if (win != XCB_WINDOW_NONE && win != root) {
-		for (Desk *d = desks; d; d = d->next) {
-			if (d->win == win) {
-				return d;
-			}
-		}
-	}
-	return NULL;
+	return winlookup(win, WIN_DESK);
 }
 
 Panel *wintopanel(xcb_window_t win)
 {
-	if (win != XCB_WINDOW_NONE && win != root) {
-		for (Panel *p = panels; p; p = p->next) {
-			if (p->win == win) {
-				return p;
-			}
-		}
-	}
-	return NULL;
+	return winlookup(win, WIN_PANEL);
 }
 
 xcb_window_t wintrans(xcb_window_t win)
+{
+	xcb_get_property_cookie_t pc = xcb_icccm_get_wm_transient_for(con, win);
+
+	return transreply(&pc);
+}
+
+static xcb_window_t transreply(xcb_get_property_cookie_t *pc)
 {
 	xcb_window_t w;
 	xcb_generic_error_t *e;
 
-	if (!xcb_icccm_get_wm_transient_for_reply(con, xcb_icccm_get_wm_transient_for(con, win), &w, &e)) {
+	if (!xcb_icccm_get_wm_transient_for_reply(con, *pc, &w, &e)) {
 		iferr(0, "unable to get wm transient for hint", e);
-		return XCB_WINDOW_NONE;
+		w = XCB_WINDOW_NONE;
 	}
+	pc->sequence = 0;
 	return w;
 }
 
+static void winunindex(xcb_window_t win)
+{
+	WinIdx *w, **ww;
+
+	if (!wintabsize) {
+		return;
+	}
+	for (ww = &wintab[winhash(win, wintabsize)]; (w = *ww); ww = &w->next) {
+		if (w->win == win) {
+			*ww = w->next;
+			free(w);
+			wintabcount--;
+			return;
+		}
+	}
+}
+
 void winunmap(xcb_window_t win)
 {
 	DBG("winunmap: 0x%08x", win)
-	xcb_get_window_attributes_reply_t *ra = winattr(root), *ca = winattr(win);
-	uint32_t rm = (ra->your_event_mask & ~XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY);
-	uint32_t cm = (ca->your_event_mask & ~XCB_EVENT_MASK_STRUCTURE_NOTIFY);
+	/* only clients are unmapped here so both masks are already known, no
+	 * need to ask the server for them */
+	uint32_t ra = monitors->next ? (rootmask | XCB_EVENT_MASK_POINTER_MOTION) : rootmask;
+	uint32_t rm = ra & ~XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY;
+	uint32_t cm = clientmask & ~XCB_EVENT_MASK_STRUCTURE_NOTIFY;
 
 	xcb_grab_server(con);
 	xcb_change_window_attributes(con, root, XCB_CW_EVENT_MASK, &rm);
 	xcb_change_window_attributes(con, win, XCB_CW_EVENT_MASK, &cm);
 	xcb_unmap_window(con, win);
 	setwinstate(win, XCB_ICCCM_WM_STATE_WITHDRAWN);
-	xcb_change_window_attributes(con, root, XCB_CW_EVENT_MASK, &ra->your_event_mask);
-	xcb_change_window_attributes(con, win, XCB_CW_EVENT_MASK, &ca->your_event_mask);
-	xcb_aux_sync(con);
+	xcb_change_window_attributes(con, root, XCB_CW_EVENT_MASK, &ra);
+	xcb_change_window_attributes(con, win, XCB_CW_EVENT_MASK, &clientmask);
 	xcb_ungrab_server(con);
 }
 
@@ -7,7 +7,6 @@
 #pragma once
 
 #include <sys/un.h>
-#include <sys/select.h>
 #include <sys/socket.h>
 
 #include <stdio.h>
@@ -19,6 +18,7 @@
 #include <err.h>
 
 #include <xcb/randr.h>
+#include <xcb/sync.h>
 #include <xcb/xproto.h>
 #include <xcb/xcb_util.h>
 #include <xcb/xcb_icccm.h>
@@ -98,6 +98,20 @@ enum States {
 	STATE_NOABSORB = 1 << 16,
 };
 
+/* what refresh() has to redo for a workspace, see setdirty() */
+enum Dirty {
+	DIRTY_LAYOUT = 1 << 0,
+	DIRTY_STACK = 1 << 1,
+	DIRTY_FOCUS = 1 << 2,
+	DIRTY_ALL = DIRTY_LAYOUT | DIRTY_STACK | DIRTY_FOCUS,
+};
+
+enum GeomFlags {
+	GEOM_FLOAT = 1 << 0, /* doesn't fit, pop it to floating */
+	GEOM_HIDE = 1 << 1,  /* tiled but not shown, eg. inactive windows in mono */
+	GEOM_KEEP = 1 << 2,  /* nothing solved for it, leave it where it is */
+};
+
 enum Cursors {
 	CURS_MOVE = 0,
 	CURS_NORMAL = 1,
@@ -153,8 +167,10 @@ enum NetAtoms {
 	NET_WM_STATE = 20,
 	NET_WM_STRUT = 21,
 	NET_WM_STRUTP = 22,
-	NET_WM_TYPE = 23,
-	NET_LAST = 24,
+	NET_WM_SYNC = 23,
+	NET_WM_SYNCCTR = 24,
+	NET_WM_TYPE = 25,
+	NET_LAST = 26,
 };
 
 enum Gravities {
@@ -173,6 +189,20 @@ enum StatusType {
 	STAT_WIN = 2,
 	STAT_BAR = 3,
 	STAT_FULL = 4,
+	STAT_DELTA = 5,
+	STAT_LAST = 6,
+};
+
+enum StatusField {
+	STATF_NAME = 0,
+	STATF_NUMBER = 1,
+	STATF_FOCUSED = 2,
+	STATF_ACTIVE = 3,
+	STATF_MONITOR = 4,
+	STATF_LAYOUT = 5,
+	STATF_TITLE = 6,
+	STATF_ID = 7,
+	STATF_LAST = 8,
 };
 
 enum CfgType {
@@ -194,7 +224,10 @@ enum GlobalSettings {
 	GLB_TILE_HINTS = 9,
 	GLB_TILE_TOHEAD = 10,
 	GLB_OBEY_MOTIF = 11,
-	GLB_LAST = 12,
+	GLB_EVENT_BATCH = 12,
+	GLB_CMD_BATCH = 13,
+	GLB_TILE_OUTLINE = 14,
+	GLB_LAST = 15,
 };
 
 typedef struct Callback Callback;
@@ -205,9 +238,10 @@ typedef struct Monitor {
 	int num, connected;
 	int x, y, w, h;
 	int wx, wy, ww, wh;
+	int rate;
 	xcb_randr_output_t id;
 	struct Monitor *next;
-	Workspace *ws;
+	Workspace *ws, *shown;
 } Monitor;
 
 typedef struct Desk {
@@ -240,11 +274,26 @@ typedef struct Panel {
 	Monitor *mon;
 } Panel;
 
+typedef struct Conn {
+	int fd, session, eof;
+	size_t len, size;
+	char *buf;
+	FILE *resp;
+	struct Conn *next;
+} Conn;
+
 typedef struct Status {
-	int num;
+	int num, framed;
 	uint32_t type;
 	FILE *file;
 	char *path;
+	char *queue; /* unsent output, see statuswrite() */
+	size_t qlen, qmsg;
+	unsigned long seq; /* last delta event sent */
+	char *mon; /* filters, only what matches them is output */
+	uint32_t fields, ws[8];
+	int rate, pending; /* most messages a second, 0 is unlimited */
+	long last;         /* when the last message went out in ms */
 	struct Status *next;
 } Status;
 
@@ -256,6 +305,16 @@ typedef struct Client {
 	pid_t pid;
 	float min_aspect, max_aspect;
 	uint32_t state, old_state;
+	struct {
+		int32_t x, y, w, h, bw;
+		uint32_t border[6];
+	} sent; /* last geometry and border given to the window, see clientgeom() */
+	struct {
+		xcb_sync_counter_t counter;
+		xcb_sync_alarm_t alarm;
+		uint64_t value;
+		int waiting;
+	} sync; /* _NET_WM_SYNC_REQUEST state, see syncrequest() */
 	xcb_window_t win;
 	Workspace *ws;
 	const Callback *cb;
@@ -272,9 +331,15 @@ typedef struct WsCmd {
 	int (*func)(Workspace *);
 } WsCmd;
 
+/* one tiled client's place in a solved layout, see layoutws() */
+typedef struct Geom {
+	int x, y, w, h, bw;
+	uint32_t flags;
+} Geom;
+
 typedef struct Layout {
 	const char *name;
-	int (*func)(Workspace *);
+	int (*func)(Workspace *, Geom *, int);
 	int implements_resize;
 	int invert_split_direction;
 	int tile_resize;
@@ -296,11 +361,15 @@ struct Workspace {
 	int padr, padl, padt, padb;
 	float msplit, ssplit;
 	Layout *layout;
-	int num;
+	int num, lytret;
+	uint32_t dirty;
+	uint64_t lytkey; /* inputs of the last layout pass, see layoutws() */
 	char name[64];
 	Monitor *mon;
 	Workspace *next;
 	Client *sel, *stack, *clients;
+	Client **tiled; /* scratch space, only valid right after tilecount() */
+	int tiledsize;
 };
 
 /* dk.c values */
@@ -308,8 +377,10 @@ extern FILE *cmdresp;
 extern uint32_t lockmask;
 extern char *argv0, **environ;
 extern int running, restart, needsrefresh, status_usingcmdresp, depth;
-extern int scr_h, scr_w, randrbase, cmdusemon, winchange, wschange, lytchange;
+extern int scr_h, scr_w, epfd, randrbase, syncbase, cmdusemon, winchange, wschange, lytchange, clichange;
+extern unsigned long reqelided;
 
+extern Conn *conns;
 extern Desk *desks;
 extern Rule *rules;
 extern Panel *panels;
@@ -331,6 +402,7 @@ extern const char *netatoms[NET_LAST];
 extern const char *cursors[CURS_LAST];
 extern const char *dirs[DIR_END];
 extern const char *gravs[GRAV_LAST];
+extern const char *statfields[STATF_LAST];
 extern const char *slayouts[];
 
 /* config.h values */
@@ -352,15 +424,18 @@ void attach(Client *c, int tohead);
 void attachstack(Client *c);
 void changews(Workspace *ws, int swap, int warp);
 void clientborder(Client *c, int focused);
+int clientgeom(Client *c, int x, int y, int w, int h, int bw);
 void clienthints(Client *c);
+void clientmove(Client *c, int x, int y);
 void clientmotif(void);
 int clientname(Client *c);
 void clientrule(Client *c, Rule *wr, int nofocus);
+void clientsync(Client *c);
 void clienttype(Client *c);
 Monitor *coordtomon(int x, int y);
 void detach(Client *c, int reattach);
 void detachstack(Client *c);
-void execcfg(void);
+void execcfg(int optional);
 void fillstruts(Panel *p);
 void focus(Client *c);
 void freerule(Rule *r);
@@ -373,19 +448,20 @@ Rule *initrule(Rule *wr);
 Status *initstatus(Status *tmp);
 Monitor *itomon(int num);
 Workspace *itows(int num);
+int loadcfg(FILE *errs);
 void manage(xcb_window_t win, int scan);
 void movestack(int direction);
 Monitor *nextmon(Monitor *m);
-Client *nexttiled(Client *c);
 void numlockmask(void);
 void popfloat(Client *c);
 void quadrant(Client *c, int *x, int *y, const int *w, const int *h);
 void refresh(void);
 void relocate(Client *c, Monitor *mon, Monitor *old);
-void resize(Client *c, int x, int y, int w, int h, int bw);
+int resize(Client *c, int x, int y, int w, int h, int bw);
 void resizehint(Client *c, int x, int y, int w, int h, int bw, int usermotion, int mouse);
 void sendconfigure(Client *c);
 int sendwmproto(Client *c, xcb_atom_t proto);
+void setdirty(Workspace *ws, uint32_t flags);
 void setfullscreen(Client *c, int fullscreen);
 void setinputfocus(Client *c);
 void setnetstate(xcb_window_t win, uint32_t state);
@@ -396,7 +472,6 @@ void setwinstate(xcb_window_t win, uint32_t state);
 void setworkspace(Client *c, Workspace *ws, int stacktail);
 void showhide(Client *c);
 void sizehints(Client *c, int uss);
-int tilecount(Workspace *ws);
 void unfocus(Client *c, int focusroot);
 void unmanage(xcb_window_t win, int destroyed);
 int updrandr(int init);
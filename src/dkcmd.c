@@ -127,19 +127,96 @@ static int json_pretty(int argc, char *argv[])
 	return 0;
 }
 
+static size_t readfile(int argc, char *argv[], char **buf)
+{
+	size_t n = 0, size = BUFSIZ;
+	FILE *f = stdin;
+
+	if (argc && *argv && strcmp(*argv, "-") && !(f = fopen(*argv, "r"))) {
+		err(1, "unable to open file: %s", *argv);
+	}
+	*buf = malloc(size);
+	while (*buf && !feof(f) && !ferror(f)) {
+		if (size - n < BUFSIZ && !(*buf = realloc(*buf, (size *= 2)))) {
+			break;
+		}
+		n += fread(*buf + n, 1, size - n - 1, f);
+	}
+	if (!*buf) {
+		err(1, "unable to allocate space");
+	}
+	(*buf)[n++] = '\0';
+	fclose(f);
+	return n;
+}
+
+static int session(int fd, char *prog)
+{
+	ssize_t n;
+	size_t len = 0, size = BUFSIZ;
+	int ret = 0;
+	char *frame, *end, buf[BUFSIZ], *resp = NULL;
+	struct pollfd fds[] = {
+		{fd,           POLLIN, 0},
+		{STDIN_FILENO, POLLIN, 0},
+	};
+
+	if (send(fd, "session\n", 8, 0) == -1) {
+		err(1, "unable to start session");
+	}
+	resp = malloc(size);
+	while (resp && poll(fds, 2, -1) > 0) {
+		if (fds[1].revents & (POLLIN | POLLHUP)) {
+			/* commands are passed along as-is, dk splits them on newlines */
+			if ((n = read(STDIN_FILENO, buf, sizeof(buf))) > 0) {
+				check(send(fd, buf, n, 0), "unable to send command");
+			} else {
+				shutdown(fd, SHUT_WR);
+				fds[1].fd = -1;
+			}
+		}
+		if (fds[0].revents & (POLLIN | POLLHUP)) {
+			if (size - len < BUFSIZ && !(resp = realloc(resp, (size *= 2)))) {
+				break;
+			}
+			if ((n = recv(fd, resp + len, size - len - 1, 0)) <= 0) {
+				break;
+			}
+			len += n;
+			resp[len] = '\0';
+			/* every response is terminated by a null byte */
+			for (frame = resp; (end = memchr(frame, '\0', len - (frame - resp))); frame = end + 1) {
+				if (*frame == '!') {
+					ret = 1;
+					fprintf(stderr, "%s: error: %s\n", prog, frame + 1);
+					fflush(stderr);
+				} else if (*frame) {
+					fprintf(stdout, "%s\n", frame);
+					fflush(stdout);
+				}
+			}
+			len -= frame - resp;
+			memmove(resp, frame, len);
+		}
+	}
+	free(resp);
+	close(fd);
+	return ret;
+}
+
 int main(int argc, char *argv[])
 {
 	if (argc == 1) {
-		return usage(argv[0], VERSION, 1, 'h', "[-hv] <COMMAND>");
+		return usage(argv[0], VERSION, 1, 'h', "[-hvs] [-f [FILE]] <COMMAND>");
 	} else if (!strcmp(argv[1], "-v") || !strcmp(argv[1], "-h")) {
-		return usage(argv[0], VERSION, 0, argv[1][1], "[-hv] <COMMAND>");
+		return usage(argv[0], VERSION, 0, argv[1][1], "[-hvs] [-f [FILE]] <COMMAND>");
 	} else if (!strcmp(argv[1], "-p")) {
 		return json_pretty(argc - 2, argv + 2);
 	}
 
 	size_t j = 0, n = 0;
 	int i, fd, ret = 0, offs = 1;
-	char *sock, *equal = NULL, *space = NULL, buf[BUFSIZ], resp[BUFSIZ];
+	char *sock, *equal = NULL, *space = NULL, *buf, resp[BUFSIZ];
 	struct sockaddr_un addr;
 	struct pollfd fds[] = {
 		{-1,            POLLIN,  0},
@@ -158,30 +235,49 @@ int main(int argc, char *argv[])
 	}
 	check(connect(fd, (struct sockaddr *)&addr, sizeof(addr)), "unable to connect socket");
 
-	for (i = 1, j = 0, offs = 1; n + 1 < sizeof(buf) && i < argc; i++, j = 0, offs = 1) {
-		if ((space = strchr(argv[i], ' ')) || (space = strchr(argv[i], '\t'))) {
-			if (!(equal = strchr(argv[i], '=')) || space < equal) {
-				buf[n++] = '"';
-			}
-			offs++;
+	if (!strcmp(argv[1], "-s")) {
+		return session(fd, argv[0]);
+	}
+
+	if (!strcmp(argv[1], "-f")) {
+		n = readfile(argc - 2, argv + 2, &buf);
+	} else {
+		/* each argument can gain two quotes and a separator */
+		for (i = 1; i < argc; i++) {
+			n += strlen(argv[i]) + 3;
+		}
+		if (!(buf = malloc(n + 1))) {
+			err(1, "unable to allocate space");
 		}
-		while (n + offs + 1 < sizeof(buf) && argv[i][j]) {
-			buf[n++] = argv[i][j++];
-			if (equal && space > equal && buf[n - 1] == '=') {
+		for (i = 1, j = 0, n = 0, offs = 1; i < argc; i++, j = 0, offs = 1) {
+			if ((space = strchr(argv[i], ' ')) || (space = strchr(argv[i], '\t'))) {
+				if (!(equal = strchr(argv[i], '=')) || space < equal) {
+					buf[n++] = '"';
+				}
+				offs++;
+			}
+			while (argv[i][j]) {
+				buf[n++] = argv[i][j++];
+				if (equal && space > equal && buf[n - 1] == '=') {
+					buf[n++] = '"';
+					equal = NULL;
+				}
+			}
+			if (offs > 1) {
 				buf[n++] = '"';
-				equal = NULL;
 			}
+			buf[n++] = ' ';
 		}
-		if (offs > 1) {
-			buf[n++] = '"';
-		}
-		buf[n++] = ' ';
+		buf[n - 1] = '\0';
 	}
-	buf[n - 1] = '\0';
-
-	check(send(fd, buf, n, 0), "unable to send command");
 
+	/* the message ends at the null byte, however long it is */
 	ssize_t s;
+	for (j = 0; j < n; j += s) {
+		check((s = send(fd, buf + j, n - j, 0)), "unable to send command");
+	}
+	free(buf);
+
 	while (poll(fds, 2, -1) > 0) {
 		if (fds[0].revents & POLLIN) {
 			if ((s = recv(fd, resp, sizeof(resp) - 1, 0)) > 0) {
@@ -4,6 +4,8 @@
  * vim:ft=c:fdm=syntax:ts=4:sts=4:sw=4
  */
 
+#include <poll.h>
+#include <time.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <regex.h>
@@ -18,8 +20,21 @@
 #include "dk.h"
 #include "cmd.h"
 #include "event.h"
+#include "layout.h"
 
-int released = 1, grabbing = 0;
+/* longest we'll hold back a resize for a client to ack the last one (ms) */
+#define SYNC_TIMEOUT 100
+
+int released = 1, grabbing = 0, syncwaiting = 0;
+
+static long frame, lastframe;
+static xcb_window_t outlines[2];
+static xcb_generic_event_t *held;
+
+static struct {
+	int set;
+	uint32_t seq;
+} ignoring[XCB_NO_OPERATION + 1];
 
 static void (*handlers[XCB_NO_OPERATION + 1])(xcb_generic_event_t *) = {
 	[XCB_BUTTON_PRESS] = &buttonpress,
@@ -106,23 +121,23 @@ void clientmessage(xcb_generic_event_t *ev)
 				return;
 			}
 			setworkspace(c, ws, c != c->ws->sel);
-			wschange = winchange = needsrefresh = 1;
+			setdirty(c->ws, DIRTY_ALL);
+			wschange = winchange = 1;
 		} else if (e->type == netatom[NET_WM_STATE]) {
 			if (d[1] == netatom[NET_STATE_FULL] || d[2] == netatom[NET_STATE_FULL]) {
 				int full = (d[0] == 1 || (d[0] == 2 && !STATE(c, FULLSCREEN)));
 				if (VISIBLE(c)) {
 					setfullscreen(c, full);
 					ignore(XCB_ENTER_NOTIFY);
-					xcb_aux_sync(con);
 				}
 			} else if (d[1] == netatom[NET_STATE_ABOVE] || d[2] == netatom[NET_STATE_ABOVE]) {
 				int above = d[0] == 1 || (d[0] == 2 && !STATE(c, ABOVE));
 				if (above && !STATE(c, ABOVE)) {
 					c->state |= STATE_ABOVE | STATE_FLOATING;
-					needsrefresh = 1;
+					setdirty(c->ws, DIRTY_ALL);
 				} else if (!above && STATE(c, ABOVE)) {
 					c->state &= ~STATE_ABOVE;
-					needsrefresh = 1;
+					setdirty(c->ws, DIRTY_ALL);
 				}
 			} else if (d[1] == netatom[NET_STATE_DEMANDATT] || d[2] == netatom[NET_STATE_DEMANDATT]) {
 				setnetstate(c->win, c->state);
@@ -203,7 +218,10 @@ void configrequest(xcb_generic_event_t *ev)
 				c->y = m->y + (m->h / 2 - H(c) / 2);
 			}
 			applysizehints(c, &c->x, &c->y, &c->w, &c->h, c->bw, 0, 0);
-			resize(c, c->x, c->y, c->w, c->h, c->bw);
+			if (!resize(c, c->x, c->y, c->w, c->h, c->bw)) {
+				/* nothing moved, the client still expects a reply */
+				sendconfigure(c);
+			}
 		} else {
 			sendconfigure(c);
 		}
@@ -231,6 +249,12 @@ void dispatch(xcb_generic_event_t *ev)
 	short type;
 
 	if ((type = XCB_EVENT_RESPONSE_TYPE(ev))) {
+		if (type <= XCB_NO_OPERATION && ignoring[type].set) {
+			if ((int32_t)(ev->full_sequence - ignoring[type].seq) < 0) {
+				return;
+			}
+			ignoring[type].set = 0;
+		}
 		if (handlers[type]) {
 			handlers[type](ev);
 		} else if (ev->response_type == randrbase + XCB_RANDR_SCREEN_CHANGE_NOTIFY &&
@@ -239,6 +263,8 @@ void dispatch(xcb_generic_event_t *ev)
 				updworkspaces(globalcfg[GLB_NUM_WS].val);
 			}
 			updstruts();
+		} else if (syncbase >= 0 && type == syncbase + XCB_SYNC_ALARM_NOTIFY) {
+			syncnotify(ev);
 		}
 	} else {
 		xcb_generic_error_t *e = (xcb_generic_error_t *)ev;
@@ -308,15 +334,11 @@ void focusin(xcb_generic_event_t *ev)
 
 void ignore(uint8_t type)
 {
-	xcb_generic_event_t *ev = NULL;
-
-	xcb_flush(con);
-	while (running && (ev = xcb_poll_for_event(con))) {
-		if (XCB_EVENT_RESPONSE_TYPE(ev) != type) {
-			dispatch(ev);
-		}
-		free(ev);
-	}
+	/* events carry the sequence of the last request the server processed
+	 * before generating them, so anything of this type older than a no-op
+	 * sent now was caused by requests we've already made */
+	ignoring[type].seq = xcb_no_operation(con).sequence;
+	ignoring[type].set = 1;
 }
 
 void mappingnotify(xcb_generic_event_t *ev)
@@ -356,24 +378,86 @@ void motionnotify(xcb_generic_event_t *ev)
 	}
 }
 
+/* stop waiting on sync acks, including clients moved to the scratchpad */
+static void syncexpire(void)
+{
+	Client *c;
+	Workspace *ws;
+
+	for (ws = workspaces; ws; ws = ws->next) {
+		for (c = ws->clients; c; c = c->next) {
+			c->sync.waiting = 0;
+		}
+	}
+	for (c = scratch.clients; c; c = c->next) {
+		c->sync.waiting = 0;
+	}
+	syncwaiting = 0;
+}
+
+/* wait for the next event during a grab, motion is coalesced to the newest
+ * position and paced to the monitor refresh rate so fast mice don't have us
+ * configuring windows far more often than the result can be shown */
+static xcb_generic_event_t *motionevent(void)
+{
+	long now, wait;
+	struct timespec ts;
+	xcb_generic_event_t *ev, *next;
+	struct pollfd pfd = {.fd = xcb_get_file_descriptor(con), .events = POLLIN};
+
+	if (held) {
+		ev = held, held = NULL;
+		return ev;
+	}
+	xcb_flush(con);
+	if (!(ev = xcb_wait_for_event(con)) || XCB_EVENT_RESPONSE_TYPE(ev) != XCB_MOTION_NOTIFY) {
+		return ev;
+	}
+	for (;;) {
+		while ((next = xcb_poll_for_event(con))) {
+			if (syncbase >= 0 && XCB_EVENT_RESPONSE_TYPE(next) == syncbase + XCB_SYNC_ALARM_NOTIFY) {
+				syncnotify(next);
+				free(next);
+				continue;
+			}
+			if (XCB_EVENT_RESPONSE_TYPE(next) != XCB_MOTION_NOTIFY) {
+				/* keep the order, this one goes after the motion */
+				held = next;
+				break;
+			}
+			free(ev);
+			ev = next;
+		}
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		now = ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+		/* clients that asked for _NET_WM_SYNC_REQUEST get to finish drawing
+		 * the last size before being sent another, within reason */
+		wait = syncwaiting ? SYNC_TIMEOUT : frame;
+		if (held || now - lastframe >= wait || poll(&pfd, 1, wait - (now - lastframe)) <= 0) {
+			break;
+		}
+	}
+	if (syncwaiting && !held) {
+		syncexpire();
+	}
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	lastframe = ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+	return ev;
+}
+
 static void mousemotion_move(Client *c, int mx, int my)
 {
 	Monitor *m = selws->mon;
-	xcb_timestamp_t last = 0;
 	xcb_motion_notify_event_t *e;
 	xcb_generic_event_t *ev = NULL;
 	int ox = c->x, oy = c->y, nx, ny, w, h;
 
 	/* single pass to ensure the border is drawn and the client is floating */
 	if (!FLOATING(c) || (STATE(c, FULLSCREEN) && STATE(c, FAKEFULL))) {
-		while (running && !released && (ev = xcb_wait_for_event(con))) {
+		while (running && !released && (ev = motionevent())) {
 			switch (XCB_EVENT_RESPONSE_TYPE(ev)) {
 				case XCB_MOTION_NOTIFY:
 					e = (xcb_motion_notify_event_t *)ev;
-					if (e->time - last < 1000 / 60) {
-						break;
-					}
-					last = e->time;
 					nx = ox + (e->root_x - mx);
 					ny = oy + (e->root_y - my);
 					if (nx == c->x && ny == c->y) {
@@ -382,7 +466,7 @@ static void mousemotion_move(Client *c, int mx, int my)
 					c->state |= STATE_FLOATING;
 					c->old_state |= STATE_FLOATING;
 					if (selws->layout->func) {
-						selws->layout->func(selws);
+						layoutws(selws);
 					}
 					setstackmode(c->win, XCB_STACK_MODE_ABOVE);
 					w = c->w, h = c->h;
@@ -400,14 +484,10 @@ static void mousemotion_move(Client *c, int mx, int my)
 		}
 	}
 primary_loop:
-	while (running && !released && (ev = xcb_wait_for_event(con))) {
+	while (running && !released && (ev = motionevent())) {
 		switch (XCB_EVENT_RESPONSE_TYPE(ev)) {
 			case XCB_MOTION_NOTIFY:
 				e = (xcb_motion_notify_event_t *)ev;
-				if (e->time - last < 1000 / 60) {
-					break;
-				}
-				last = e->time;
 				nx = ox + (e->root_x - mx);
 				ny = oy + (e->root_y - my);
 				if (nx == c->x && ny == c->y) {
@@ -421,8 +501,9 @@ primary_loop:
 				w = c->w, h = c->h;
 				if (applysizehints(c, &nx, &ny, &w, &h, c->bw, 1, 1)) {
 					c->x = nx, c->y = ny, c->w = w, c->h = h;
-					MOVERESIZE(c->win, c->x, c->y, c->w, c->h, c->bw);
-					sendconfigure(c);
+					if (clientgeom(c, c->x, c->y, c->w, c->h, c->bw)) {
+						sendconfigure(c);
+					}
 					xcb_flush(con);
 				}
 				break;
@@ -439,20 +520,14 @@ primary_loop:
 /* already floating windows and tiled layouts that don't support resize */
 static void mousemotion_resize(Client *c, int mx, int my)
 {
-	xcb_timestamp_t last = 0;
 	xcb_motion_notify_event_t *e;
 	xcb_generic_event_t *ev = NULL;
 	int x, y, nw, nh, ow = c->w, oh = c->h;
-	;
 
-	while (running && !released && (ev = xcb_wait_for_event(con))) {
+	while (running && !released && (ev = motionevent())) {
 		switch (XCB_EVENT_RESPONSE_TYPE(ev)) {
 			case XCB_MOTION_NOTIFY:
 				e = (xcb_motion_notify_event_t *)ev;
-				if (e->time - last < 1000 / 60) {
-					break;
-				}
-				last = e->time;
 				nw = ow + (e->root_x - mx);
 				nh = oh + (e->root_y - my);
 				if (nw == c->w && nh == c->h) {
@@ -462,7 +537,7 @@ static void mousemotion_resize(Client *c, int mx, int my)
 					c->state |= STATE_FLOATING;
 					c->old_state |= STATE_FLOATING;
 					if (selws->layout->func) {
-						selws->layout->func(selws);
+						layoutws(selws);
 					}
 					setstackmode(c->win, XCB_STACK_MODE_ABOVE);
 				}
@@ -494,44 +569,105 @@ static void mousemotion_resize(Client *c, int mx, int my)
 		} else {                                                                                             \
 			c->hoff = isend ? (e->root_y - my) * -1 : e->root_y - my;                                        \
 		}                                                                                                    \
-		if (selws->layout->func(selws) < 0) {                                                                \
+		if (layoutws(selws) < 0) {                                                                           \
 			c->hoff = ohoff;                                                                                 \
-			selws->layout->func(selws);                                                                      \
+			layoutws(selws);                                                                                 \
 		}                                                                                                    \
-	} else if (selws->layout->func(selws) < 0) {                                                             \
-		selws->layout->func(selws);                                                                          \
+	} else {                                                                                                 \
+		layoutws(selws);                                                                                     \
 	}                                                                                                        \
 	xcb_flush(con)
 
+/* thin bars standing in for the split and height offset while tile_outline
+ * holds the relayout back until the button is released */
+static void outline(Client *c, Monitor *m, int edge, int dy, int hoff, int isend)
+{
+	int t = MAX(border[BORD_WIDTH], 2);
+	uint32_t v[] = {border[BORD_FOCUS], 1};
+	uint32_t g[2][5] = {
+		{CLAMP(edge, m->wx, m->wx + m->ww) - t / 2, m->wy, t, m->wh, XCB_STACK_MODE_ABOVE},
+		{c->x, CLAMP((isend ? c->y : c->y + H(c)) + dy, m->wy, m->wy + m->wh) - t / 2, W(c), t,
+		 XCB_STACK_MODE_ABOVE},
+	};
+
+	for (int i = 0; i < (hoff ? 2 : 1); i++) {
+		if (!outlines[i]) {
+			outlines[i] = xcb_generate_id(con);
+			xcb_create_window(con, XCB_COPY_FROM_PARENT, outlines[i], root, g[i][0], g[i][1], g[i][2],
+							  g[i][3], 0, XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_COPY_FROM_PARENT,
+							  XCB_CW_BACK_PIXEL | XCB_CW_OVERRIDE_REDIRECT, v);
+			xcb_map_window(con, outlines[i]);
+		}
+		xcb_configure_window(con, outlines[i],
+							 XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y | XCB_CONFIG_WINDOW_WIDTH |
+								 XCB_CONFIG_WINDOW_HEIGHT | XCB_CONFIG_WINDOW_STACK_MODE,
+							 g[i]);
+	}
+}
+
+static void outlinefree(void)
+{
+	for (uint32_t i = 0; i < LEN(outlines); i++) {
+		if (outlines[i]) {
+			xcb_destroy_window(con, outlines[i]);
+			outlines[i] = XCB_WINDOW_NONE;
+		}
+	}
+}
+
+static void splitt(Monitor *m, int idx, int ox, int ow, int dx)
+{
+	if (selws->nstack && idx >= selws->nstack + selws->nmaster) {
+		selws->ssplit =
+			CLAMP((ox - m->x + dx - (m->w * selws->msplit)) / (m->w - (m->w * selws->msplit)), 0.05, 0.95);
+	} else if (selws->nmaster && idx >= selws->nmaster) {
+		selws->msplit = CLAMP((float)(ox - m->x + dx) / m->w, 0.05, 0.95);
+	} else {
+		selws->msplit = CLAMP((float)(ox - m->x + ow + dx) / m->w, 0.05, 0.95);
+	}
+}
+
+static void splittinv(Monitor *m, int idx, int ox, int ow, int dx)
+{
+	if (selws->nstack && idx >= selws->nstack + selws->nmaster) {
+		selws->ssplit = CLAMP((ox - m->x + ow - dx) / (m->w - (m->w * selws->msplit)), 0.05, 0.95);
+	} else if (selws->nmaster && idx >= selws->nmaster) {
+		selws->msplit = CLAMP((float)(ox - m->x + ow - dx) / m->w, 0.05, 0.95);
+	} else {
+		selws->msplit = CLAMP((float)(ox - m->x - dx) / m->w, 0.05, 0.95);
+	}
+}
+
 /* layouts that support resize with standard tiling direction */
 static void mousemotion_resizet(Client *c, Client *prev, int idx, int mx, int my, int isend, int nearend)
 {
 	Monitor *m = selws->mon;
-	xcb_timestamp_t last = 0;
-	xcb_motion_notify_event_t *e;
+	xcb_motion_notify_event_t *e, last;
 	xcb_generic_event_t *ev = NULL;
-	int first = 1, ow = c->w, ox = c->x;
+	int first = 1, moved = 0, ow = c->w, ox = c->x;
+	int master = !(selws->nstack && idx >= selws->nstack + selws->nmaster) &&
+				 !(selws->nmaster && idx >= selws->nmaster);
 
-	while (running && !released && (ev = xcb_wait_for_event(con))) {
+	while (running && !released && (ev = motionevent())) {
 		switch (XCB_EVENT_RESPONSE_TYPE(ev)) {
 			case XCB_MOTION_NOTIFY:
 				e = (xcb_motion_notify_event_t *)ev;
-				if (e->time - last < 1000 / 60) {
+				if (globalcfg[GLB_TILE_OUTLINE].val) {
+					last = *e, moved = 1;
+					outline(c, m, (master ? ox + ow : ox) + (e->root_x - mx), e->root_y - my, prev || nearend,
+							isend);
 					break;
 				}
-				last = e->time;
-				if (selws->nstack && idx >= selws->nstack + selws->nmaster) {
-					selws->ssplit = CLAMP((ox - m->x + (e->root_x - mx) - (m->w * selws->msplit)) /
-											  (m->w - (m->w * selws->msplit)),
-										  0.05, 0.95);
-				} else if (selws->nmaster && idx >= selws->nmaster) {
-					selws->msplit = CLAMP((float)(ox - m->x + (e->root_x - mx)) / m->w, 0.05, 0.95);
-				} else {
-					selws->msplit = CLAMP((float)(ox - m->x + ow + (e->root_x - mx)) / m->w, 0.05, 0.95);
-				}
+				splitt(m, idx, ox, ow, e->root_x - mx);
 				HEIGHT_OFFSET;
 				break;
 			case XCB_BUTTON_RELEASE:
+				if (moved) {
+					outlinefree();
+					e = &last;
+					splitt(m, idx, ox, ow, e->root_x - mx);
+					HEIGHT_OFFSET;
+				}
 				buttonrelease(0);
 				break;
 			default: dispatch(ev);
@@ -544,30 +680,32 @@ static void mousemotion_resizet(Client *c, Client *prev, int idx, int mx, int my
 static void mousemotion_resizetinv(Client *c, Client *prev, int idx, int mx, int my, int isend, int nearend)
 {
 	Monitor *m = selws->mon;
-	xcb_timestamp_t last = 0;
-	xcb_motion_notify_event_t *e;
+	xcb_motion_notify_event_t *e, last;
 	xcb_generic_event_t *ev = NULL;
-	int first = 1, ow = c->w, ox = c->x;
+	int first = 1, moved = 0, ow = c->w, ox = c->x;
+	int master = !(selws->nstack && idx >= selws->nstack + selws->nmaster) &&
+				 !(selws->nmaster && idx >= selws->nmaster);
 
-	while (running && !released && (ev = xcb_wait_for_event(con))) {
+	while (running && !released && (ev = motionevent())) {
 		switch (XCB_EVENT_RESPONSE_TYPE(ev)) {
 			case XCB_MOTION_NOTIFY:
 				e = (xcb_motion_notify_event_t *)ev;
-				if (e->time - last < 1000 / 60) {
+				if (globalcfg[GLB_TILE_OUTLINE].val) {
+					last = *e, moved = 1;
+					outline(c, m, (master ? ox : ox + ow) + (e->root_x - mx), e->root_y - my, prev || nearend,
+							isend);
 					break;
 				}
-				last = e->time;
-				if (selws->nstack && idx >= selws->nstack + selws->nmaster) {
-					selws->ssplit = CLAMP(
-						(ox - m->x + ow - (e->root_x - mx)) / (m->w - (m->w * selws->msplit)), 0.05, 0.95);
-				} else if (selws->nmaster && idx >= selws->nmaster) {
-					selws->msplit = CLAMP((float)(ox - m->x + ow - (e->root_x - mx)) / m->w, 0.05, 0.95);
-				} else {
-					selws->msplit = CLAMP((float)(ox - m->x - (e->root_x - mx)) / m->w, 0.05, 0.95);
-				}
+				splittinv(m, idx, ox, ow, e->root_x - mx);
 				HEIGHT_OFFSET;
 				break;
 			case XCB_BUTTON_RELEASE:
+				if (moved) {
+					outlinefree();
+					e = &last;
+					splittinv(m, idx, ox, ow, e->root_x - mx);
+					HEIGHT_OFFSET;
+				}
 				buttonrelease(0);
 				break;
 			default: dispatch(ev);
@@ -580,21 +718,22 @@ static void mousemotion_resizetinv(Client *c, Client *prev, int idx, int mx, int
 void mousemotion(Client *c, xcb_button_t button, int mx, int my)
 {
 	grabbing = 1, released = 0;
+	frame = 1000 / MAX(selws->mon->rate, 1), lastframe = 0;
 
 	if (button == mousemove) {
 		mousemotion_move(c, mx, my);
 	} else {
 		if (!FLOATING(c) && c->ws->layout->implements_resize) {
-			int i, isend, nearend;
-			Client *p, *prev = NULL;
-			for (i = 0, p = nexttiled(selws->clients); p && p != c; p = nexttiled(p->next), i++) {
-				if (nexttiled(p->next) == c) {
-					prev = (i + 1 == selws->nmaster || i + 1 == selws->nstack + selws->nmaster) ? NULL : p;
-				}
+			int i, n, isend, nearend;
+			Client *prev = NULL;
+			for (i = 0, n = tilecount(selws); i < n && selws->tiled[i] != c; i++)
+				;
+			if (i && i != selws->nmaster && i != selws->nstack + selws->nmaster) {
+				prev = selws->tiled[i - 1];
 			}
 			/* calculate these here to save the resize loops extra unnecessary work */
-			isend = i + 1 == selws->nmaster || i + 1 == selws->nmaster + selws->nstack || !nexttiled(c->next);
-			nearend = (i == selws->nmaster || i == selws->nmaster + selws->nstack) && nexttiled(c->next);
+			isend = i + 1 == selws->nmaster || i + 1 == selws->nmaster + selws->nstack || i + 1 >= n;
+			nearend = (i == selws->nmaster || i == selws->nmaster + selws->nstack) && i + 1 < n;
 
 			if (!selws->layout->invert_split_direction) {
 				mousemotion_resizet(c, prev, i, mx, my, isend, nearend);
@@ -605,6 +744,15 @@ void mousemotion(Client *c, xcb_button_t button, int mx, int my)
 			mousemotion_resize(c, mx, my);
 		}
 	}
+	if (held) {
+		dispatch(held);
+		free(held);
+		held = NULL;
+	}
+	if (syncwaiting) {
+		syncexpire();
+	}
+	outlinefree();
 }
 
 void propertynotify(xcb_generic_event_t *ev)
@@ -623,7 +771,7 @@ void propertynotify(xcb_generic_event_t *ev)
 			case XCB_ATOM_WM_TRANSIENT_FOR:
 				if ((c->trans = wintoclient(wintrans(c->win))) && !FLOATING(c)) {
 					c->state |= STATE_FLOATING;
-					needsrefresh = 1;
+					setdirty(c->ws, DIRTY_ALL);
 				}
 				break;
 			default:
@@ -633,27 +781,48 @@ void propertynotify(xcb_generic_event_t *ev)
 					}
 				} else if (e->atom == netatom[NET_WM_TYPE]) {
 					clienttype(c);
+				} else if (e->atom == netatom[NET_WM_SYNCCTR]) {
+					clientsync(c);
 				}
 		}
 	} else if ((e->atom == netatom[NET_WM_STRUTP] || e->atom == netatom[NET_WM_STRUT]) &&
 			   (p = wintopanel(e->window))) {
 		fillstruts(p);
 		updstruts();
-		needsrefresh = 1;
+	}
+}
+
+void syncnotify(xcb_generic_event_t *ev)
+{
+	Client *c;
+	Workspace *ws;
+	xcb_sync_alarm_notify_event_t *e = (xcb_sync_alarm_notify_event_t *)ev;
+	uint64_t val = ((uint64_t)(uint32_t)e->counter_value.hi << 32) | e->counter_value.lo;
+
+	for (ws = workspaces, c = NULL; ws && !c; ws = ws->next) {
+		for (c = ws->clients; c && c->sync.alarm != e->alarm; c = c->next)
+			;
+	}
+	if (!c) {
+		/* a client can be sent to the scratchpad while being waited on */
+		for (c = scratch.clients; c && c->sync.alarm != e->alarm; c = c->next)
+			;
+	}
+	if (c && c->sync.waiting && val >= c->sync.value) {
+		c->sync.waiting = 0;
+		syncwaiting--;
 	}
 }
 
 void unmapnotify(xcb_generic_event_t *ev)
 {
-	xcb_generic_error_t *er;
 	xcb_unmap_notify_event_t *e = (xcb_unmap_notify_event_t *)ev;
 
+	/* no need to check the window still exists, when it's been destroyed
+	 * the withdraw requests in unmanage() fail with BadWindow which
+	 * dispatch() already drops and the DestroyNotify behind this finds
+	 * nothing left to do */
 	if (e->event != root) {
-		free(xcb_query_tree_reply(con, xcb_query_tree(con, e->window), &er));
-		if (er) {
-			free(er);
-			return;
-		}
 		DBG("unmapnotify: un-managing window: 0x%08x", e->window)
 		unmanage(e->window, 0);
 	}
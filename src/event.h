@@ -6,6 +6,8 @@
 
 #pragma once
 
+extern int grabbing, syncwaiting;
+
 void buttonpress(xcb_generic_event_t *ev);
 void buttonrelease(int move);
 void clientmessage(xcb_generic_event_t *ev);
@@ -21,4 +23,5 @@ void maprequest(xcb_generic_event_t *ev);
 void motionnotify(xcb_generic_event_t *ev);
 void mousemotion(Client *c, xcb_button_t button, int mx, int my);
 void propertynotify(xcb_generic_event_t *ev);
+void syncnotify(xcb_generic_event_t *ev);
 void unmapnotify(xcb_generic_event_t *ev);
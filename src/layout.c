@@ -13,18 +13,14 @@
 #include <xcb/xcb_keysyms.h>
 
 #include "dk.h"
+#include "util.h"
 #include "layout.h"
 
-int dwindle(Workspace *ws)
+int dwindle(Workspace *ws, Geom *geo, int n)
 {
 	Client *c;
 	Monitor *m = ws->mon;
-	uint32_t i, n;
-	int x, y, w, h, ww, g, f = 0, ret = 1;
-
-	if (!(n = tilecount(ws))) {
-		return 1;
-	}
+	int i, x, y, w, h, ww, g, f = 0, ret = 1;
 
 	if (globalcfg[GLB_SMART_GAP].val && n == 1) {
 		g = 0, ws->smartgap = 1;
@@ -38,8 +34,8 @@ int dwindle(Workspace *ws)
 	h = m->wh - ws->padt - ws->padb;
 	ww = w;
 
-	for (i = 0, c = nexttiled(ws->clients); c; c = nexttiled(c->next), i++) {
-		uint32_t ox = x, oy = y;
+	for (i = 0; i < n && (c = ws->tiled[i]); i++) {
+		int ox = x, oy = y;
 		int *p = (i % 2) ? &h : &w;
 		int b = globalcfg[GLB_SMART_BORDER].val && n == 1 ? 0 : c->bw;
 		if (i < n - 1) {
@@ -60,7 +56,7 @@ int dwindle(Workspace *ws)
 		}
 		if (f || *p - g - (2 * b) < globalcfg[GLB_MIN_WH].val) {
 			if (f) {
-				popfloat(c);
+				geo[i].flags |= GEOM_FLOAT;
 				ret = -1;
 				continue;
 			}
@@ -73,21 +69,18 @@ int dwindle(Workspace *ws)
 				x = ox;
 			}
 		}
-		resizehint(c, x + g, y + g, w - g - (2 * b), h - g - (2 * b), b, 0, 0);
+		geo[i] = (Geom){x + g, y + g, w - g - (2 * b), h - g - (2 * b), b, 0};
 	}
 	return ret;
 }
 
-int grid(Workspace *ws)
+int grid(Workspace *ws, Geom *geo, int n)
 {
 	Client *c;
 	Monitor *m = ws->mon;
 	int wx, wy, ww, wh;
-	int i, n, g, cols, rows, col, row;
+	int i, g, cols, rows, col, row;
 
-	if (!(n = tilecount(ws))) {
-		return 1;
-	}
 	for (cols = 0; cols <= n / 2; cols++) {
 		if (cols * cols >= n) {
 			break;
@@ -109,7 +102,7 @@ int grid(Workspace *ws)
 		g = ws->gappx, ws->smartgap = 0;
 	}
 
-	for (i = col = row = 0, c = nexttiled(ws->clients); c; i++, c = nexttiled(c->next)) {
+	for (i = col = row = 0; i < n && (c = ws->tiled[i]); i++) {
 		if (i / MAX(1, rows) + 1 > cols - n % cols) {
 			rows = n / cols + 1;
 		}
@@ -118,7 +111,7 @@ int grid(Workspace *ws)
 		int cw = cols ? (ww - g) / cols : ww;
 		int cx = (wx + g) + col * cw;
 		int cy = (wy + g) + row * ch;
-		resizehint(c, cx, cy, cw - (2 * b) - g, ch - (2 * b) - g, b, 0, 0);
+		geo[i] = (Geom){cx, cy, cw - (2 * b) - g, ch - (2 * b) - g, b, 0};
 		if (++row >= rows) {
 			row = 0;
 			col++;
@@ -127,19 +120,118 @@ int grid(Workspace *ws)
 	return 1;
 }
 
-int ltile(Workspace *ws)
+static uint64_t keymix(uint64_t key, uint64_t v)
+{
+	/* FNV-1a over each value as a whole word */
+	return (key ^ v) * 0x100000001b3ULL;
+}
+
+/* hash of everything a layout pass reads and writes: the workspace settings,
+ * the work area, the ordered tiled clients and where they were last put, when
+ * it matches what was stored after the last pass there's nothing to do */
+static uint64_t layoutkey(Workspace *ws, int n)
 {
 	Client *c;
 	Monitor *m = ws->mon;
-	int i, g, n, x, *y, remain, ret = 0, p = -1, pbw = 0;
-	int mw, my, sw, sy, ss, ssw, ssy, ns = 1;
-	int minh = globalcfg[GLB_MIN_WH].val;
+	uint32_t ms, ss;
+	uint64_t key = 0xcbf29ce484222325ULL;
+
+	memcpy(&ms, &ws->msplit, sizeof(ms));
+	memcpy(&ss, &ws->ssplit, sizeof(ss));
+	key = keymix(key, (uintptr_t)ws->layout->func);
+	key = keymix(key, ((uint64_t)ms << 32) | ss);
+	key = keymix(key, ((uint64_t)(uint32_t)ws->nmaster << 32) | (uint32_t)ws->nstack);
+	key = keymix(key, ((uint64_t)(uint32_t)ws->gappx << 32) | (uint32_t)ws->padl);
+	key = keymix(key, ((uint64_t)(uint32_t)ws->padr << 32) | (uint32_t)ws->padt);
+	key = keymix(key, ((uint64_t)(uint32_t)ws->padb << 32) | (uint32_t)globalcfg[GLB_MIN_WH].val);
+	key = keymix(key, ((uint64_t)(uint32_t)m->wx << 32) | (uint32_t)m->wy);
+	key = keymix(key, ((uint64_t)(uint32_t)m->ww << 32) | (uint32_t)m->wh);
+	key = keymix(key, (globalcfg[GLB_SMART_GAP].val << 2) | (globalcfg[GLB_SMART_BORDER].val << 1) |
+						  globalcfg[GLB_TILE_HINTS].val);
+	if (ws->layout->func == mono) {
+		key = keymix(key, (uintptr_t)ws->sel);
+	}
+	for (int i = 0; i < n && (c = ws->tiled[i]); i++) {
+		key = keymix(key, (uintptr_t)c);
+		key = keymix(key, ((uint64_t)(uint32_t)c->hoff << 32) | ((uint32_t)c->bw << 1) | c->hints);
+		key = keymix(key, ((uint64_t)(uint32_t)c->x << 32) | (uint32_t)c->y);
+		key = keymix(key, ((uint64_t)(uint32_t)c->w << 32) | (uint32_t)c->h);
+		key = keymix(key, ((uint64_t)(uint32_t)c->sent.x << 32) | (uint32_t)c->sent.y);
+		key = keymix(key, ((uint64_t)(uint32_t)c->sent.w << 32) | (uint32_t)c->sent.h);
+		key = keymix(key, (uint32_t)c->sent.bw);
+	}
+	return key;
+}
 
-	if (!(n = tilecount(ws))) {
+/* solve the workspace layout then apply it, anything the layout couldn't fit
+ * is popped to floating and the rest solved again before a single request is
+ * sent for them, returns < 0 when the minimum size was exceeded
+ *
+ * the pass is skipped when nothing it depends on changed since the last one,
+ * returning what that pass did */
+int layoutws(Workspace *ws)
+{
+	Client *c;
+	uint64_t key;
+	int i, n, ret, popped;
+
+	if (!ws->layout->func) {
 		return 1;
 	}
+	n = tilecount(ws);
+	if ((key = layoutkey(ws, n)) == ws->lytkey) {
+		return ws->lytret;
+	}
+	do {
+		if (!n) {
+			ret = 1;
+			break;
+		}
+		Geom geo[n];
+		memset(geo, 0, sizeof(geo));
+		ret = ws->layout->func(ws, geo, n);
+		popped = 0;
+		for (i = 0; i < n && (c = ws->tiled[i]); i++) {
+			if (geo[i].flags & GEOM_FLOAT) {
+				popfloat(c);
+				popped = 1;
+			}
+		}
+		if (popped) {
+			n = tilecount(ws);
+			continue;
+		}
+		for (i = 0; i < n && (c = ws->tiled[i]); i++) {
+			if (geo[i].flags & GEOM_KEEP) {
+				continue;
+			} else if (geo[i].flags & GEOM_HIDE) {
+				/* keep the size it'll have when shown but park it off screen */
+				c->x = geo[i].x, c->y = geo[i].y;
+				c->w = MAX(geo[i].w, globalcfg[GLB_MIN_WH].val);
+				c->h = MAX(geo[i].h, globalcfg[GLB_MIN_WH].val);
+				if (clientgeom(c, W(c) * -2, c->y, c->w, c->h, geo[i].bw)) {
+					sendconfigure(c);
+				}
+			} else {
+				resizehint(c, geo[i].x, geo[i].y, geo[i].w, geo[i].h, geo[i].bw, 0, 0);
+				clientmove(c, c->x, c->y);
+			}
+		}
+	} while (popped);
+	ws->lytkey = layoutkey(ws, n);
+	ws->lytret = ret;
+	return ret;
+}
+
+int ltile(Workspace *ws, Geom *geo, int n)
+{
+	Client *c;
+	Monitor *m = ws->mon;
+	int i, g, x, *y, remain, ret = 0, p = -1, pbw = 0;
+	int mw, my, sw, sy, ss, ssw, ssy, ns = 1;
+	int minh = globalcfg[GLB_MIN_WH].val;
+
 	mw = ss = sw = ssw = 0;
-	int geo[n + 1][4];
 	int wx = m->wx + ws->padl;
 	int wy = m->wy + ws->padt;
 	int ww = m->ww - ws->padl - ws->padr;
@@ -172,90 +264,91 @@ int ltile(Workspace *ws)
 	 * the previous client if needed. There's a lot of messy maths to adjust
 	 * the size of each window using it's height offset and stack split ratio.
 	 */
-	for (i = 0, my = sy = ssy = g, c = nexttiled(ws->clients); c; c = nexttiled(c->next), ++i) {
+	for (i = 0, my = sy = ssy = g; i < n && (c = ws->tiled[i]); ++i) {
 		if (i < ws->nmaster) {
 			remain = MIN(n, ws->nmaster) - i;
 			x = g;
 			y = &my;
-			geo[i][2] = mw - g * (5 - ns) / 2;
+			geo[i].w = mw - g * (5 - ns) / 2;
 		} else if (i - ws->nmaster < ws->nstack) {
 			remain = MIN(n - ws->nmaster, ws->nstack) - (i - ws->nmaster);
 			x = mw + (g / ns);
 			y = &sy;
-			geo[i][2] =
+			geo[i].w =
 				(sw - g * (5 - ns - ss) / 2) + (!ws->nmaster && n > ws->nmaster + ws->nstack ? g / 2 : 0);
 		} else {
 			remain = n - i;
 			x = mw + sw + (g / ns) - (!ws->nmaster ? g / 2 : 0);
 			y = &ssy;
-			geo[i][2] = (ssw - g * (5 - ns) / 2) + (!ws->nmaster ? g / 2 : 0);
+			geo[i].w = (ssw - g * (5 - ns) / 2) + (!ws->nmaster ? g / 2 : 0);
 		}
-		geo[i][0] = wx + x;
-		geo[i][1] = wy + *y;
+		geo[i].x = wx + x;
+		geo[i].y = wy + *y;
 		int bw = !globalcfg[GLB_SMART_BORDER].val || n > 1 ? c->bw : 0;
 		if (p == -1 && remain == 1) {
-			geo[i][3] = wh - *y - g;
+			geo[i].h = wh - *y - g;
 			goto update;
 		} else {
-			geo[i][3] = ((wh - *y) / MAX(1, remain)) - g + c->hoff;
+			geo[i].h = ((wh - *y) / MAX(1, remain)) - g + c->hoff;
 		}
-		int available = wh - (*y + geo[i][3] + g);
-		if (!c->hoff && geo[i][3] - (2 * bw) < minh) {
-			popfloat(c);
+		int available = wh - (*y + geo[i].h + g);
+		if (!c->hoff && geo[i].h - (2 * bw) < minh) {
+			geo[i].flags |= GEOM_FLOAT;
 			continue;
 		} else if (remain > 1 && (remain - 1) * (minh + g + (2 * bw)) > available) {
-			geo[i][3] += available - ((remain - 1) * (minh + g + (2 * bw)));
+			geo[i].h += available - ((remain - 1) * (minh + g + (2 * bw)));
 			ret = -1;
-		} else if (remain == 1 && *y + geo[i][3] != wh - g) {
+		} else if (remain == 1 && *y + geo[i].h != wh - g) {
 			if (p != -1) {
-				if (geo[p][3] + available < minh + (2 * bw)) {
-					geo[p][3] = minh + (2 * pbw);
-					geo[i][1] = geo[p][1] + geo[p][3] + g + (2 * pbw);
-					geo[i][3] = (wh - (2 * g)) - (geo[p][1] + geo[p][3]) - (2 * pbw);
+				if (geo[p].h + available < minh + (2 * bw)) {
+					geo[p].h = minh + (2 * pbw);
+					geo[i].y = geo[p].y + geo[p].h + g + (2 * pbw);
+					geo[i].h = (wh - (2 * g)) - (geo[p].y + geo[p].h) - (2 * pbw);
 					ret = -1;
-				} else if (geo[i][3] <= minh) {
-					geo[p][3] -= minh - geo[i][3] + (2 * bw);
-					geo[i][1] = geo[p][1] + geo[p][3] + g;
-					geo[i][3] = minh + (2 * bw);
+				} else if (geo[i].h <= minh) {
+					geo[p].h -= minh - geo[i].h + (2 * bw);
+					geo[i].y = geo[p].y + geo[p].h + g;
+					geo[i].h = minh + (2 * bw);
 					ret = -1;
 				} else {
-					geo[p][3] += available;
-					geo[i][1] += available;
+					geo[p].h += available;
+					geo[i].y += available;
 				}
 			} else {
-				geo[i][3] = available;
+				geo[i].h = available;
 			}
-		} else if (geo[i][3] - (2 * bw) < minh) {
-			geo[i][3] = remain == 1 ? wh - (2 * g) : minh + (2 * bw);
+		} else if (geo[i].h - (2 * bw) < minh) {
+			geo[i].h = remain == 1 ? wh - (2 * g) : minh + (2 * bw);
 			ret = -1;
 		}
 update:
-		*y += geo[i][3] + g;
-		geo[i][2] -= (2 * bw);
-		geo[i][3] -= (2 * bw);
+		*y += geo[i].h + g;
+		geo[i].w -= (2 * bw);
+		geo[i].h -= (2 * bw);
+		geo[i].bw = bw;
 		p = (remain == 1 && n - i != 0) ? -1 : i;
 		pbw = bw;
 	}
 
-	/* Do the actual resizing, if a client goes below the minimum allowed size
-	 * we return -1 to signify the layout exceeded it.
-	 */
-	for (i = 0, c = nexttiled(ws->clients); c; c = nexttiled(c->next), i++) {
-		if (geo[i][3] <= globalcfg[GLB_MIN_WH].val) {
+	/* if a client goes below the minimum allowed size we return -1 to
+	 * signify the layout exceeded it */
+	for (i = 0; i < n; i++) {
+		if (!(geo[i].flags & GEOM_FLOAT) && geo[i].h <= minh) {
 			ret = -1;
 		}
-		resizehint(c, geo[i][0], geo[i][1], geo[i][2], geo[i][3],
-				   !globalcfg[GLB_SMART_BORDER].val || n > 1 ? c->bw : 0, 0, 0);
 	}
 	return ret;
 }
 
-int mono(Workspace *ws)
+int mono(Workspace *ws, Geom *geo, int n)
 {
-	int g;
+	int i, g;
 	Client *c;
 
 	if (!ws->sel) {
+		for (i = 0; i < n; i++) {
+			geo[i].flags = GEOM_KEEP;
+		}
 		return 1;
 	}
 	if (globalcfg[GLB_SMART_GAP].val) {
@@ -266,30 +359,32 @@ int mono(Workspace *ws)
 
 	int b = globalcfg[GLB_SMART_BORDER].val ? 0 : ws->sel->bw;
 
-	for (c = nexttiled(ws->clients); c; c = nexttiled(c->next)) {
-		resizehint(c, ws->mon->wx + ws->padl + g, ws->mon->wy + ws->padt + g,
-				   ws->mon->ww - ws->padl - ws->padr - (2 * g) - (2 * b),
-				   ws->mon->wh - ws->padt - ws->padb - (2 * g) - (2 * b), b, 0, 0);
-		if (c != c->ws->sel) { /* hide inactive windows */
-			MOVE(c->win, W(c) * -2, c->y);
-		}
+	for (i = 0; i < n && (c = ws->tiled[i]); i++) {
+		geo[i] = (Geom){ws->mon->wx + ws->padl + g, ws->mon->wy + ws->padt + g,
+						ws->mon->ww - ws->padl - ws->padr - (2 * g) - (2 * b),
+						ws->mon->wh - ws->padt - ws->padb - (2 * g) - (2 * b), b,
+						c != ws->sel ? GEOM_HIDE : 0}; /* hide inactive windows */
 	}
 	return 1;
 }
 
-int rtile(Workspace *ws)
+Client *nexttiled(Client *c)
+{
+	while (c && FLOATING(c)) {
+		c = c->next;
+	}
+	return c;
+}
+
+int rtile(Workspace *ws, Geom *geo, int n)
 {
 	Client *c;
 	Monitor *m = ws->mon;
-	int i, g, n, x, *y, remain, ret = 0, p = -1, pbw = 0;
+	int i, g, x, *y, remain, ret = 0, p = -1, pbw = 0;
 	int mw, my, sw, sy, ss, ssw, ssy, ns = 1;
 	int minh = globalcfg[GLB_MIN_WH].val;
 
-	if (!(n = tilecount(ws))) {
-		return 1;
-	}
 	mw = ss = sw = ssw = 0;
-	int geo[n + 1][4];
 	int wx = m->wx + ws->padl;
 	int wy = m->wy + ws->padt;
 	int ww = m->ww - ws->padl - ws->padr;
@@ -318,97 +413,91 @@ int rtile(Workspace *ws)
 		ss = 0;
 	}
 
-	for (i = 0, my = sy = ssy = g, c = nexttiled(ws->clients); c; c = nexttiled(c->next), ++i) {
+	for (i = 0, my = sy = ssy = g; i < n && (c = ws->tiled[i]); ++i) {
 		if (i < ws->nmaster) {
 			remain = MIN(n, ws->nmaster) - i;
 			x = sw + ssw + (g / ns);
 			y = &my;
-			geo[i][2] = mw - g * (5 - ns) / 2;
+			geo[i].w = mw - g * (5 - ns) / 2;
 		} else if (i - ws->nmaster < ws->nstack) {
 			remain = MIN(n - ws->nmaster, ws->nstack) - (i - ws->nmaster);
 			x = n <= ws->nmaster + ws->nstack
 					? g
 					: (ssw + g / ns) - (!ws->nmaster && n > ws->nmaster + ws->nstack ? g / 2 : 0);
 			y = &sy;
-			geo[i][2] =
+			geo[i].w =
 				(sw - g * (5 - ns - ss) / 2) + (!ws->nmaster && n > ws->nmaster + ws->nstack ? g / 2 : 0);
 		} else {
 			remain = n - i;
 			x = g;
 			y = &ssy;
-			geo[i][2] = ssw - g * (5 - ns) / 2;
+			geo[i].w = ssw - g * (5 - ns) / 2;
 			if (!ws->nmaster) {
-				geo[i][2] += g / 2;
+				geo[i].w += g / 2;
 			}
 		}
-		geo[i][0] = wx + x;
-		geo[i][1] = wy + *y;
+		geo[i].x = wx + x;
+		geo[i].y = wy + *y;
 		int bw = !globalcfg[GLB_SMART_BORDER].val || n > 1 ? c->bw : 0;
 		if (p == -1 && remain == 1) {
-			geo[i][3] = wh - *y - g;
+			geo[i].h = wh - *y - g;
 			goto update;
 		} else {
-			geo[i][3] = ((wh - *y) / MAX(1, remain)) - g + c->hoff;
+			geo[i].h = ((wh - *y) / MAX(1, remain)) - g + c->hoff;
 		}
-		int available = wh - (*y + geo[i][3] + g);
-		if (!c->hoff && geo[i][3] - (2 * bw) < minh) {
-			popfloat(c);
+		int available = wh - (*y + geo[i].h + g);
+		if (!c->hoff && geo[i].h - (2 * bw) < minh) {
+			geo[i].flags |= GEOM_FLOAT;
 			ret = -1;
 			continue;
 		} else if (remain > 1 && (remain - 1) * (minh + g + (2 * bw)) > available) {
-			geo[i][3] += available - ((remain - 1) * (minh + g + (2 * bw)));
+			geo[i].h += available - ((remain - 1) * (minh + g + (2 * bw)));
 			ret = -1;
-		} else if (remain == 1 && *y + geo[i][3] != wh - g) {
+		} else if (remain == 1 && *y + geo[i].h != wh - g) {
 			if (p != -1) {
-				if (geo[p][3] + available < minh + (2 * bw)) {
-					geo[p][3] = minh + (2 * pbw);
-					geo[i][1] = geo[p][1] + geo[p][3] + g + (2 * pbw);
-					geo[i][3] = (wh - (2 * g)) - (geo[p][1] + geo[p][3]) - (2 * pbw);
+				if (geo[p].h + available < minh + (2 * bw)) {
+					geo[p].h = minh + (2 * pbw);
+					geo[i].y = geo[p].y + geo[p].h + g + (2 * pbw);
+					geo[i].h = (wh - (2 * g)) - (geo[p].y + geo[p].h) - (2 * pbw);
 					ret = -1;
-				} else if (geo[i][3] <= minh) {
-					geo[p][3] -= minh - geo[i][3] + (2 * bw);
-					geo[i][1] = geo[p][1] + geo[p][3] + g;
-					geo[i][3] = minh + (2 * bw);
+				} else if (geo[i].h <= minh) {
+					geo[p].h -= minh - geo[i].h + (2 * bw);
+					geo[i].y = geo[p].y + geo[p].h + g;
+					geo[i].h = minh + (2 * bw);
 					ret = -1;
 				} else {
-					geo[p][3] += available;
-					geo[i][1] += available;
+					geo[p].h += available;
+					geo[i].y += available;
 				}
 			} else {
-				geo[i][3] = available;
+				geo[i].h = available;
 			}
-		} else if (geo[i][3] - (2 * bw) < minh) {
-			geo[i][3] = remain == 1 ? wh - (2 * g) : minh + (2 * bw);
+		} else if (geo[i].h - (2 * bw) < minh) {
+			geo[i].h = remain == 1 ? wh - (2 * g) : minh + (2 * bw);
 			ret = -1;
 		}
 update:
-		*y += geo[i][3] + g;
-		geo[i][2] -= (2 * bw);
-		geo[i][3] -= (2 * bw);
+		*y += geo[i].h + g;
+		geo[i].w -= (2 * bw);
+		geo[i].h -= (2 * bw);
+		geo[i].bw = bw;
 		p = (remain == 1 && n - i != 0) ? -1 : i;
 		pbw = bw;
 	}
 
-	for (i = 0, c = nexttiled(ws->clients); c; c = nexttiled(c->next), i++) {
-		if (geo[i][3] <= globalcfg[GLB_MIN_WH].val) {
+	for (i = 0; i < n; i++) {
+		if (!(geo[i].flags & GEOM_FLOAT) && geo[i].h <= minh) {
 			ret = -1;
 		}
-		resizehint(c, geo[i][0], geo[i][1], geo[i][2], geo[i][3],
-				   !globalcfg[GLB_SMART_BORDER].val || n > 1 ? c->bw : 0, 0, 0);
 	}
 	return ret;
 }
 
-int spiral(Workspace *ws)
+int spiral(Workspace *ws, Geom *geo, int n)
 {
 	Client *c;
 	Monitor *m = ws->mon;
-	uint32_t i, n;
-	int x, y, w, h, ww, g, f = 0, ret = 1;
-
-	if (!(n = tilecount(ws))) {
-		return 1;
-	}
+	int i, x, y, w, h, ww, g, f = 0, ret = 1;
 
 	if (globalcfg[GLB_SMART_GAP].val && n == 1) {
 		g = 0, ws->smartgap = 1;
@@ -422,8 +511,8 @@ int spiral(Workspace *ws)
 	h = m->wh - ws->padt - ws->padb;
 	ww = w;
 
-	for (i = 0, c = nexttiled(ws->clients); c; c = nexttiled(c->next), i++) {
-		uint32_t ox = x, oy = y;
+	for (i = 0; i < n && (c = ws->tiled[i]); i++) {
+		int ox = x, oy = y;
 		int *p = (i % 2) ? &h : &w;
 		int b = globalcfg[GLB_SMART_BORDER].val && n == 1 ? 0 : c->bw;
 		if (i < n - 1) {
@@ -450,7 +539,7 @@ int spiral(Workspace *ws)
 
 		if (f || *p - g - (2 * b) < globalcfg[GLB_MIN_WH].val) {
 			if (f) {
-				popfloat(c);
+				geo[i].flags |= GEOM_FLOAT;
 				ret = -1;
 				continue;
 			}
@@ -463,7 +552,25 @@ int spiral(Workspace *ws)
 				x = ox;
 			}
 		}
-		resizehint(c, x + g, y + g, w - (2 * b) - g, h - (2 * b) - g, b, 0, 0);
+		geo[i] = (Geom){x + g, y + g, w - (2 * b) - g, h - (2 * b) - g, b, 0};
 	}
 	return ret;
 }
+
+int tilecount(Workspace *ws)
+{
+	int n = 0;
+	Client *c;
+
+	/* the walk also fills ws->tiled so callers can index the tiled clients
+	 * afterwards rather than stepping through nexttiled() again, it's
+	 * rebuilt by every call and not kept up to date in between */
+	for (c = nexttiled(ws->clients); c; c = nexttiled(c->next)) {
+		if (n == ws->tiledsize) {
+			ws->tiledsize = ws->tiledsize ? ws->tiledsize * 2 : 16;
+			ws->tiled = erealloc(ws->tiled, ws->tiledsize * sizeof(Client *));
+		}
+		ws->tiled[n++] = c;
+	}
+	return n;
+}
@@ -6,9 +6,12 @@
 
 #pragma once
 
-int dwindle(Workspace *ws);
-int grid(Workspace *ws);
-int ltile(Workspace *ws);
-int mono(Workspace *ws);
-int rtile(Workspace *ws);
-int spiral(Workspace *ws);
+int dwindle(Workspace *ws, Geom *geo, int n);
+int grid(Workspace *ws, Geom *geo, int n);
+int layoutws(Workspace *ws);
+int ltile(Workspace *ws, Geom *geo, int n);
+int mono(Workspace *ws, Geom *geo, int n);
+Client *nexttiled(Client *c);
+int rtile(Workspace *ws, Geom *geo, int n);
+int spiral(Workspace *ws, Geom *geo, int n);
+int tilecount(Workspace *ws);
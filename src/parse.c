@@ -143,9 +143,8 @@ void parsecmd(char *buf)
 		respond(cmdresp, "!invalid or unknown command: %s", *argv);
 	}
 end:
-	if (cmdresp && !status_usingcmdresp) {
+	if (cmdresp) {
 		fflush(cmdresp);
-		fclose(cmdresp);
 	}
 	free(save);
 }
@@ -171,7 +170,9 @@ int parsecolour(char *arg, uint32_t *result)
 		} else {
 			*result = argb;
 		}
-		needsrefresh = needsrefresh || orig != *result;
+		if (orig != *result) {
+			setdirty(NULL, DIRTY_ALL);
+		}
 		return 1;
 	}
 	return -1;
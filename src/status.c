@@ -4,13 +4,70 @@
  * vim:ft=c:fdm=syntax:ts=4:sts=4:sw=4
  */
 
+#include <err.h>
+#include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/epoll.h>
 
 #include "dk.h"
+#include "strl.h"
+#include "util.h"
+#include "layout.h"
 #include "status.h"
 
 #define STOB(v, s) STATE(v, s) ? "true" : "false"
 
+/* most unsent output kept for a subscriber before it's dropped */
+#define STATUS_QUEUE (4 << 20)
+
+/* whether the subscriber being rendered for wants a workspace bar field */
+#define FIELD(f) (!scope || !scope->fields || (scope->fields & (1u << (f))))
+
+typedef struct DeltaClient {
+	xcb_window_t win;
+	int ws;
+	char title[256];
+	Client *c;
+} DeltaClient;
+
+/* a filtered render kept for the rest of the round so subscribers with the
+ * same filters share it, the filters are copied as a subscriber can be freed
+ * before the round is over */
+typedef struct Filtered {
+	uint32_t type, fields, ws[8];
+	int hasmon;
+	char mon[64], *buf;
+	size_t len;
+} Filtered;
+
+typedef struct DeltaMon {
+	char name[64];
+	int x, y, w, h, ws;
+} DeltaMon;
+
+/* what delta subscribers have been told so far, changes are found by
+ * comparing against it once a round rather than hooking every place the
+ * state is changed, several changes in one round become a single event */
+static struct {
+	int init, ws, nclients, nmons, nws;
+	unsigned long seq, first;
+	xcb_window_t focus;
+	Layout **layouts;
+	DeltaClient *clients;
+	DeltaMon *mons;
+	FILE *f; /* events not yet sent, each followed by a null byte */
+	char *buf;
+	size_t len;
+} delta;
+
+/* filters of the subscriber being rendered for, NULL when there are none */
+static Status *scope;
+
 static void _client(Client *c, FILE *f);
 static void _clients(FILE *f);
 static void _desks(FILE *f);
@@ -22,6 +79,20 @@ static void _rules(FILE *f);
 static char *_title(Client *c);
 static void _workspaces(FILE *f);
 static void _workspace(Workspace *ws, FILE *f);
+static int changed(uint32_t type);
+static int deltacmp(const void *a, const void *b);
+static FILE *deltaevent(const char *event);
+static size_t deltaoff(unsigned long seq, int framed);
+static void deltas(void);
+static int filtered(Status *s);
+static int monok(Monitor *m);
+static long now(void);
+static void render(uint32_t type, FILE *f);
+static int samefilter(Status *s, uint32_t type, Filtered *f);
+static int statusqueue(Status *s, struct iovec *v, int nv);
+static int statuswatch(Status *s, uint32_t events);
+static int statuswrite(Status *s, char *buf, size_t len, int frame);
+static int wsok(Workspace *ws);
 
 static void _client(Client *c, FILE *f)
 {
@@ -59,35 +130,31 @@ static void _client(Client *c, FILE *f)
 		_client(c->absorbed, f);
 	}
 	fprintf(f, "}");
-	fflush(f);
 }
 
 static void _clients(FILE *f)
 {
 	Client *c;
 	Workspace *ws;
-	int hasprev = 0;
+	int n = 0;
 
 	fprintf(f, "\"clients\":[");
 	for (ws = workspaces; ws; ws = ws->next) {
+		if (!wsok(ws)) {
+			continue;
+		}
 		for (c = ws->clients; c; c = c->next) {
-			fprintf(f, "{");
+			fprintf(f, "%s{", n++ ? "," : "");
 			_client(c, f);
-			fprintf(f, "}%s", c->next ? "," : "");
-			hasprev = 1;
-		}
-		if (hasprev && ws->next && ws->next->clients) {
-			fprintf(f, ",");
+			fprintf(f, "}");
 		}
 	}
-	if (scratch.clients) {
-		if (hasprev) {
-			fprintf(f, ",");
-		}
+	if (!scope || !filtered(scope)) {
+		/* the scratchpad isn't on any workspace or monitor */
 		for (c = scratch.clients; c; c = c->next) {
-			fprintf(f, "{");
+			fprintf(f, "%s{", n++ ? "," : "");
 			_client(c, f);
-			fprintf(f, "}%s", c->next ? "," : "");
+			fprintf(f, "}");
 		}
 	}
 	fprintf(f, "]");
@@ -147,6 +214,7 @@ static void _global(FILE *f)
 	fprintf(f, "\"outer_urgent\":\"0x%08x\",", border[BORD_O_URGENT]);
 	fprintf(f, "\"outer_unfocus\":\"0x%08x\"", border[BORD_O_UNFOCUS]);
 	fprintf(f, "},");
+	fprintf(f, "\"requests_elided\":%lu,", reqelided);
 	fprintf(f, "\"focused\":{");
 	_monitor(selmon, f);
 	fprintf(f, "}}");
@@ -173,13 +241,14 @@ static void _monitor(Monitor *m, FILE *f)
 static void _monitors(FILE *f)
 {
 	Monitor *m;
+	int n = 0;
 
 	fprintf(f, "\"monitors\":[");
 	for (m = monitors; m; m = m->next) {
-		if (m->connected) {
-			fprintf(f, "{");
+		if (m->connected && monok(m)) {
+			fprintf(f, "%s{", n++ ? "," : "");
 			_monitor(m, f);
-			fprintf(f, "}%s", m->next ? "," : "");
+			fprintf(f, "}");
 		}
 	}
 	fprintf(f, "]");
@@ -299,104 +368,577 @@ static void _workspace(Workspace *ws, FILE *f)
 static void _workspaces(FILE *f)
 {
 	Workspace *ws;
+	int n = 0;
 
 	fprintf(f, "\"workspaces\":[");
 	for (ws = workspaces; ws; ws = ws->next) {
-		fprintf(f, "{");
-		_workspace(ws, f);
-		fprintf(f, "}%s", ws->next ? "," : "");
+		if (wsok(ws)) {
+			fprintf(f, "%s{", n++ ? "," : "");
+			_workspace(ws, f);
+			fprintf(f, "}");
+		}
 	}
 	fprintf(f, "]");
 }
 
+static int changed(uint32_t type)
+{
+	switch (type) {
+		case STAT_WIN: return winchange;
+		case STAT_LYT: return lytchange;
+		case STAT_WS: return wschange;
+		case STAT_BAR: return winchange || wschange || lytchange;
+		case STAT_FULL: return winchange || wschange || lytchange || clichange;
+	}
+	return 1;
+}
+
+static int deltacmp(const void *a, const void *b)
+{
+	xcb_window_t x = ((DeltaClient *)a)->win, y = ((DeltaClient *)b)->win;
+
+	return (x > y) - (x < y);
+}
+
+static FILE *deltaevent(const char *event)
+{
+	if (!delta.f && !(delta.f = open_memstream(&delta.buf, &delta.len))) {
+		warn("unable to open status stream");
+		return NULL;
+	}
+	if (!delta.first) {
+		delta.first = delta.seq + 1;
+	}
+	fprintf(delta.f, "{\"seq\":%lu,\"event\":\"%s\"", ++delta.seq, event);
+	return delta.f;
+}
+
+static size_t deltaoff(unsigned long seq, int framed)
+{
+	size_t o = 0, n = 0;
+
+	/* skip the events a subscriber already has from its snapshot */
+	for (; delta.first + n <= seq && o < delta.len; n++) {
+		o = (char *)memchr(delta.buf + o, '\0', delta.len - o) - delta.buf + 1;
+	}
+	return framed ? o : o - n;
+}
+
+static void deltas(void)
+{
+	FILE *f;
+	Client *c;
+	Monitor *m;
+	Workspace *ws;
+	DeltaClient *cur;
+	int i, j, n = 0, silent = !delta.init;
+
+	if (selws->num != delta.ws && !silent && (f = deltaevent("ws_changed"))) {
+		fprintf(f, ",\"workspace\":%d,\"name\":\"%s\",\"monitor\":\"%s\"}%c", selws->num + 1,
+				selws->name, selws->mon->name, '\0');
+	}
+	delta.ws = selws->num;
+
+	for (ws = workspaces, i = 0; ws; ws = ws->next, i++)
+		;
+	if (i != delta.nws) {
+		delta.layouts = erealloc(delta.layouts, i * sizeof(Layout *));
+		for (j = delta.nws; j < i; j++) {
+			delta.layouts[j] = NULL;
+		}
+		delta.nws = i;
+	}
+	for (ws = workspaces; ws; ws = ws->next) {
+		if (ws->layout != delta.layouts[ws->num] && !silent && (f = deltaevent("layout_changed"))) {
+			fprintf(f, ",\"workspace\":%d,\"layout\":\"%s\"}%c", ws->num + 1, ws->layout->name, '\0');
+		}
+		delta.layouts[ws->num] = ws->layout;
+	}
+
+	for (m = monitors, i = 0; m; m = m->next) {
+		if (!m->connected) {
+			continue;
+		}
+		if (i >= delta.nmons) {
+			delta.mons = erealloc(delta.mons, (i + 1) * sizeof(DeltaMon));
+			memset(&delta.mons[i], 0, sizeof(DeltaMon));
+			delta.nmons = i + 1;
+		}
+		DeltaMon *dm = &delta.mons[i++];
+		if (strcmp(dm->name, m->name) || dm->x != m->x || dm->y != m->y || dm->w != m->w || dm->h != m->h ||
+			dm->ws != m->ws->num) {
+			if (!silent && (f = deltaevent("monitor_changed"))) {
+				fprintf(f, ",\"name\":\"%s\",\"x\":%d,\"y\":%d,\"w\":%d,\"h\":%d,\"workspace\":%d}%c",
+						m->name, m->x, m->y, m->w, m->h, m->ws->num + 1, '\0');
+			}
+			strlcpy(dm->name, m->name, sizeof(dm->name));
+			dm->x = m->x, dm->y = m->y, dm->w = m->w, dm->h = m->h, dm->ws = m->ws->num;
+		}
+	}
+	for (; i < delta.nmons; delta.nmons--) {
+		if (!silent && (f = deltaevent("monitor_changed"))) {
+			fprintf(f, ",\"name\":\"%s\",\"connected\":false}%c", delta.mons[delta.nmons - 1].name, '\0');
+		}
+	}
+
+	/* clients are matched up by window after sorting both sides */
+	for (ws = workspaces; ws; ws = ws->next) {
+		for (c = ws->clients; c; c = c->next, n++)
+			;
+	}
+	for (c = scratch.clients; c; c = c->next, n++)
+		;
+	cur = ecalloc(MAX(n, 1), sizeof(DeltaClient));
+	for (ws = workspaces, i = 0; ws; ws = ws->next) {
+		for (c = ws->clients; c; c = c->next, i++) {
+			cur[i] = (DeltaClient){.win = c->win, .ws = c->ws->num + 1, .c = c};
+		}
+	}
+	for (c = scratch.clients; c; c = c->next, i++) {
+		cur[i] = (DeltaClient){.win = c->win, .ws = 0, .c = c};
+	}
+	qsort(cur, n, sizeof(DeltaClient), deltacmp);
+	for (i = j = 0; !silent && (i < n || j < delta.nclients);) {
+		DeltaClient *o = j < delta.nclients ? &delta.clients[j] : NULL;
+		DeltaClient *d = i < n ? &cur[i] : NULL;
+		if (!d || (o && o->win < d->win)) {
+			if ((f = deltaevent("client_removed"))) {
+				fprintf(f, ",\"id\":\"0x%08x\"}%c", o->win, '\0');
+			}
+			j++;
+			continue;
+		}
+		if (!o || d->win < o->win) {
+			if ((f = deltaevent("client_added"))) {
+				fprintf(f, ",\"id\":\"0x%08x\",\"title\":\"%s\",", d->win, _title(d->c));
+				fprintf(f, "\"class\":\"%s\",\"instance\":\"%s\",\"workspace\":%d}%c", d->c->clss,
+						d->c->inst, d->ws, '\0');
+			}
+		} else {
+			if (strcmp(o->title, d->c->title) && (f = deltaevent("title_changed"))) {
+				fprintf(f, ",\"id\":\"0x%08x\",\"title\":\"%s\"}%c", d->win, _title(d->c), '\0');
+			}
+			if (o->ws != d->ws && (f = deltaevent("client_moved"))) {
+				fprintf(f, ",\"id\":\"0x%08x\",\"workspace\":%d}%c", d->win, d->ws, '\0');
+			}
+			j++;
+		}
+		i++;
+	}
+	for (i = 0; i < n; i++) {
+		strlcpy(cur[i].title, cur[i].c->title, sizeof(cur[i].title));
+		cur[i].c = NULL;
+	}
+	free(delta.clients);
+	delta.clients = cur;
+	delta.nclients = n;
+
+	/* last so a client added and focused is known before it's focused */
+	if ((selws->sel ? selws->sel->win : 0) != delta.focus && !silent && (f = deltaevent("focus_changed"))) {
+		if (selws->sel) {
+			fprintf(f, ",\"id\":\"0x%08x\",", selws->sel->win);
+		} else {
+			fprintf(f, ",\"id\":\"\",");
+		}
+		fprintf(f, "\"workspace\":%d}%c", selws->num + 1, '\0');
+	}
+	delta.focus = selws->sel ? selws->sel->win : 0;
+	delta.init = 1;
+	if (delta.f) {
+		fflush(delta.f);
+		/* make sure a round runs to send them */
+		clichange = 1;
+	}
+}
+
+static int filtered(Status *s)
+{
+	for (uint32_t i = 0; i < LEN(s->ws); i++) {
+		if (s->ws[i]) {
+			return 1;
+		}
+	}
+	return s->mon != NULL;
+}
+
+static int monok(Monitor *m)
+{
+	return !scope || !scope->mon || !strcmp(m->name, scope->mon);
+}
+
+static long now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void render(uint32_t type, FILE *f)
+{
+	Monitor *m;
+	Workspace *ws = selws;
+	int n = 0, k;
+
+	if (scope && scope->mon && (type == STAT_WIN || type == STAT_LYT)) {
+		/* what's shown on that monitor rather than the focused one */
+		for (m = monitors; m && !(m->connected && monok(m)); m = m->next)
+			;
+		ws = m ? m->ws : NULL;
+	}
+	switch (type) {
+		case STAT_WIN:
+			fprintf(f, "{\"focused\":\"%s\"}", ws && ws->sel ? _title(ws->sel) : "");
+			break;
+		case STAT_LYT:
+			fprintf(f, "{\"layout\":\"%s\"}", ws ? ws->layout->name : "");
+			break;
+		case STAT_WS: /* FALL THROUGH */
+		case STAT_BAR:
+			fprintf(f, "{\"workspaces\":[");
+			for (ws = workspaces; ws; ws = ws->next) {
+				if (!wsok(ws)) {
+					continue;
+				}
+				fprintf(f, "%s{", n++ ? "," : "");
+				k = 0;
+				if (FIELD(STATF_NAME)) {
+					fprintf(f, "%s\"name\":\"%s\"", k++ ? "," : "", ws->name);
+				}
+				if (FIELD(STATF_NUMBER)) {
+					fprintf(f, "%s\"number\":%d", k++ ? "," : "", ws->num + 1);
+				}
+				if (FIELD(STATF_FOCUSED)) {
+					fprintf(f, "%s\"focused\":%s", k++ ? "," : "", ws == selws ? "true" : "false");
+				}
+				if (FIELD(STATF_ACTIVE)) {
+					fprintf(f, "%s\"active\":%s", k++ ? "," : "", ws->clients ? "true" : "false");
+				}
+				if (FIELD(STATF_MONITOR)) {
+					fprintf(f, "%s\"monitor\":\"%s\"", k++ ? "," : "", ws->mon->name);
+				}
+				if (FIELD(STATF_LAYOUT)) {
+					fprintf(f, "%s\"layout\":\"%s\"", k++ ? "," : "", ws->layout->name);
+				}
+				if (ws->sel && !STATE(ws->sel, HIDDEN)) {
+					if (FIELD(STATF_TITLE)) {
+						fprintf(f, "%s\"title\":\"%s\"", k++ ? "," : "", _title(ws->sel));
+					}
+					if (FIELD(STATF_ID)) {
+						fprintf(f, "%s\"id\":\"0x%08x\"", k++ ? "," : "", ws->sel->win);
+					}
+				} else {
+					if (FIELD(STATF_TITLE)) {
+						fprintf(f, "%s\"title\":\"\"", k++ ? "," : "");
+					}
+					if (FIELD(STATF_ID)) {
+						fprintf(f, "%s\"id\":\"\"", k++ ? "," : "");
+					}
+				}
+				fprintf(f, "}");
+			}
+			fprintf(f, "]}");
+			break;
+		case STAT_FULL:
+			fprintf(f, "{");
+			_global(f);
+			fprintf(f, ",");
+			_workspaces(f);
+			fprintf(f, ",");
+			_monitors(f);
+			fprintf(f, ",");
+			_clients(f);
+			fprintf(f, ",");
+			_rules(f);
+			fprintf(f, ",");
+			_panels(f);
+			fprintf(f, ",");
+			_desks(f);
+			fprintf(f, "}");
+			break;
+		case STAT_DELTA:
+			fprintf(f, "{\"seq\":%lu,\"event\":\"snapshot\",\"state\":", delta.seq);
+			render(STAT_FULL, f);
+			fprintf(f, "}");
+			break;
+	}
+}
+
+static int samefilter(Status *s, uint32_t type, Filtered *f)
+{
+	if (type != f->type || (type == STAT_BAR ? s->fields : 0) != f->fields || memcmp(s->ws, f->ws, sizeof(f->ws)) ||
+		!s->mon != !f->hasmon) {
+		return 0;
+	}
+	return !s->mon || !strncmp(s->mon, f->mon, sizeof(f->mon));
+}
+
+static int statusqueue(Status *s, struct iovec *v, int nv)
+{
+	size_t len = 0;
+
+	for (int i = 0; i < nv; i++) {
+		len += v[i].iov_len;
+	}
+	if (s->qlen + len > STATUS_QUEUE) {
+		return -1;
+	}
+	s->queue = erealloc(s->queue, s->qlen + len);
+	for (int i = 0; i < nv; i++) {
+		memcpy(s->queue + s->qlen, v[i].iov_base, v[i].iov_len);
+		s->qlen += v[i].iov_len;
+	}
+	if (!s->qmsg) {
+		s->qmsg = s->qlen;
+	}
+	return statuswatch(s, EPOLLOUT);
+}
+
+static int statuswatch(Status *s, uint32_t events)
+{
+	int fd = fileno(s->file);
+	struct epoll_event ev = {.events = events, .data.fd = fd};
+
+	return epoll_ctl(epfd, EPOLL_CTL_MOD, fd, &ev);
+}
+
+static int statuswrite(Status *s, char *buf, size_t len, int frame)
+{
+	int fd;
+	ssize_t n;
+	struct iovec iov[2] = {{buf, len}, {"", 1}}, *v = iov;
+	int nv = frame ? 2 : 1;
+
+	/* anything still buffered in the stream has to go out first */
+	fflush(s->file);
+	if ((fd = fileno(s->file)) < 0) {
+		/* memory streams used while loading the config have no fd */
+		fwrite(buf, 1, len, s->file);
+		if (frame) {
+			fputc('\0', s->file);
+		}
+		return fflush(s->file);
+	}
+	if (s->qlen) {
+		/* still sending an earlier message, every message is a complete
+		 * snapshot so one waiting behind it is replaced by this one, except
+		 * delta events which only make sense together */
+		if (s->type != STAT_DELTA) {
+			s->qlen = s->qmsg;
+		}
+		return statusqueue(s, v, nv);
+	}
+	while (nv) {
+		if ((n = writev(fd, v, nv)) < 0) {
+			if (errno == EINTR) {
+				continue;
+			} else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				/* the reader is behind, the rest goes out when it's writable */
+				return statusqueue(s, v, nv);
+			}
+			return -1;
+		}
+		for (; nv && (size_t)n >= v->iov_len; nv--, v++) {
+			n -= v->iov_len;
+		}
+		if (nv) {
+			v->iov_base = (char *)v->iov_base + n;
+			v->iov_len -= n;
+		}
+	}
+	return 0;
+}
+
+static int wsok(Workspace *ws)
+{
+	uint32_t i;
+
+	if (!scope || !monok(ws->mon)) {
+		return !scope;
+	}
+	for (i = 0; i < LEN(scope->ws) && !scope->ws[i]; i++)
+		;
+	return i == LEN(scope->ws) || (ws->num < 256 && (scope->ws[ws->num / 32] & (1u << (ws->num % 32))));
+}
+
+void framestatus(Status *s)
+{
+	struct iovec v = {"", 1};
+
+	/* the first message was sent before the stream was known to be framed,
+	 * its terminator has to follow it out even if it's still queued */
+	s->framed = 1;
+	if (!s->qlen) {
+		statuswrite(s, "", 0, 1);
+	} else if (!statusqueue(s, &v, 1)) {
+		s->qmsg = s->qlen;
+	}
+}
+
+void flushstatus(Status *s)
+{
+	ssize_t n;
+
+	while (s->qlen) {
+		if ((n = write(fileno(s->file), s->queue, s->qlen)) < 0) {
+			if (errno == EINTR) {
+				continue;
+			} else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				return;
+			}
+			freestatus(s);
+			return;
+		}
+		memmove(s->queue, s->queue + n, s->qlen -= n);
+		/* once the first message is out, what's left is the one after it */
+		s->qmsg = (size_t)n >= s->qmsg ? s->qlen : s->qmsg - n;
+	}
+	if (!s->num || statuswatch(s, 0) < 0) {
+		/* finished sending its last message */
+		freestatus(s);
+	}
+}
+
 void printstatus(Status *s, int freeable)
 {
+	FILE *f;
 	Status *next;
-	Workspace *ws;
-	int single = 1;
+	uint32_t t;
+	size_t outlen, o;
+	int single = 1, frame, i, nfil = 0, due;
+	long ms = now();
+	char *out, *plain = NULL, *buf[STAT_LAST] = {0};
+	size_t len[STAT_LAST] = {0};
+	Filtered *fil = NULL, *cur;
 
 	if (!s) {
 		s = stats;
 		single = 0;
 	}
+	for (next = stats; next && next->type != STAT_DELTA; next = next->next)
+		;
+	if (next && (!single || s->type == STAT_DELTA)) {
+		deltas();
+	}
+	/* each type is rendered at most once and the same buffer is written
+	 * to every subscriber of it, new subscribers always get one */
 	while (s) {
 		next = s->next;
-		switch (s->type) {
-			case STAT_WIN:
-				if (winchange) {
-					winchange = 0;
-					fprintf(s->file, "{\"focused\":\"%s\"}", selws->sel ? _title(selws->sel) : "");
-				}
-				break;
-			case STAT_LYT:
-				if (lytchange) {
-					lytchange = 0;
-					fprintf(s->file, "{\"layout\":\"%s\"}", selws->layout->name);
+		t = s->type == STAT_WS ? STAT_BAR : s->type;
+		out = NULL;
+		/* a round can be run only because a held back message is due,
+		 * nothing changed for anyone else then */
+		due = single || changed(s->type) || s->pending;
+		if (!s->num && s->qlen) {
+			/* waiting on its last message to be sent */
+		} else if (t == STAT_DELTA && !single) {
+			if (delta.len && s->seq < delta.seq) {
+				if (!s->framed && !plain) {
+					plain = ecalloc(1, delta.len);
+					for (o = outlen = 0; o < delta.len; o++) {
+						if (delta.buf[o]) {
+							plain[outlen++] = delta.buf[o];
+						}
+					}
 				}
-				break;
-			case STAT_WS:
-				if (!wschange) {
-					break;
+				o = deltaoff(s->seq, s->framed);
+				out = (s->framed ? delta.buf : plain) + o;
+				outlen = (s->framed ? delta.len : delta.len - (delta.seq - delta.first + 1)) - o;
+				frame = 0;
+			}
+		} else if (due && !single && s->rate && ms - s->last < 1000 / s->rate) {
+			/* too soon after the last one, whatever the state is once it's
+			 * due goes out in a single message, see statuswait() */
+			s->pending = 1;
+		} else if (due && t != STAT_DELTA && (filtered(s) || (t == STAT_BAR && s->fields))) {
+			/* filtered renders are shared by subscribers with the same filters,
+			 * fields only change ws and bar output so elsewhere they're ignored */
+			for (i = 0; i < nfil && !samefilter(s, t, &fil[i]); i++)
+				;
+			if (i == nfil) {
+				fil = erealloc(fil, ++nfil * sizeof(Filtered));
+				cur = &fil[i];
+				memset(cur, 0, sizeof(Filtered));
+				cur->type = t, cur->fields = t == STAT_BAR ? s->fields : 0, cur->hasmon = s->mon != NULL;
+				memcpy(cur->ws, s->ws, sizeof(cur->ws));
+				if (s->mon) {
+					strlcpy(cur->mon, s->mon, sizeof(cur->mon));
 				}
-				wschange = 0;
-				/* FALL THROUGH */
-			case STAT_BAR:
-				if (s->type == STAT_BAR) {
-					winchange = lytchange = wschange = 0;
+				if ((f = open_memstream(&cur->buf, &cur->len))) {
+					scope = s;
+					render(t, f);
+					scope = NULL;
+					fclose(f);
+				} else {
+					/* only this subscriber misses the round */
+					warn("unable to open status stream");
+					nfil--;
 				}
-				fprintf(s->file, "{\"workspaces\":[");
-				for (ws = workspaces; ws; ws = ws->next) {
-					fprintf(s->file, "{");
-					fprintf(s->file, "\"name\":\"%s\",", ws->name);
-					fprintf(s->file, "\"number\":%d,", ws->num + 1);
-					fprintf(s->file, "\"focused\":%s,", ws == selws ? "true" : "false");
-					fprintf(s->file, "\"active\":%s,", ws->clients ? "true" : "false");
-					fprintf(s->file, "\"monitor\":\"%s\",", ws->mon->name);
-					fprintf(s->file, "\"layout\":\"%s\",", ws->layout->name);
-					if (ws->sel && !STATE(ws->sel, HIDDEN)) {
-						fprintf(s->file, "\"title\":\"%s\",", _title(ws->sel));
-						fprintf(s->file, "\"id\":\"0x%08x\"", ws->sel->win);
-					} else {
-						fprintf(s->file, "\"title\":\"\",");
-						fprintf(s->file, "\"id\":\"\"");
-					}
-					fprintf(s->file, "}%s", ws->next ? "," : "");
+			}
+			if (i < nfil) {
+				out = fil[i].buf, outlen = fil[i].len, frame = s->framed;
+			}
+		} else if (due) {
+			if (!buf[t]) {
+				if ((f = open_memstream(&buf[t], &len[t]))) {
+					render(t, f);
+					fclose(f);
+				} else {
+					/* only this subscriber misses the round */
+					warn("unable to open status stream");
 				}
-				fprintf(s->file, "]}");
-				break;
-			case STAT_FULL:
-				fprintf(s->file, "{");
-				_global(s->file);
-				fprintf(s->file, ",");
-				fflush(s->file);
-				_workspaces(s->file);
-				fprintf(s->file, ",");
-				fflush(s->file);
-				_monitors(s->file);
-				fprintf(s->file, ",");
-				fflush(s->file);
-				_clients(s->file);
-				fprintf(s->file, ",");
-				fflush(s->file);
-				_rules(s->file);
-				fprintf(s->file, ",");
-				fflush(s->file);
-				_panels(s->file);
-				fprintf(s->file, ",");
-				fflush(s->file);
-				_desks(s->file);
-				fprintf(s->file, "}");
-				winchange = lytchange = wschange = 0;
-				break;
+			}
+			if (buf[t]) {
+				out = buf[t], outlen = len[t], frame = s->framed;
+			}
 		}
-		fflush(s->file);
-		/* one-shot status prints have no allocations so aren't free-able */
-		if (freeable && !(s->num -= s->num > 0 ? 1 : 0)) {
-			freestatus(s);
+		if (out) {
+			s->seq = delta.seq, s->last = ms, s->pending = 0;
+			if (statuswrite(s, out, outlen, frame) < 0) {
+				if (freeable) {
+					/* the reader is gone or broken, same as a hangup */
+					freestatus(s);
+				}
+			} else if (freeable && !(s->num -= s->num > 0 ? 1 : 0) && !s->qlen) {
+				/* one-shot status prints have no allocations so aren't free-able,
+				 * ones with output still queued are freed once it's sent */
+				freestatus(s);
+			}
 		}
 		if (single) {
 			break;
 		}
 		s = next;
 	}
+	if (!single) {
+		winchange = lytchange = wschange = clichange = 0;
+		if (delta.f) {
+			fclose(delta.f);
+			free(delta.buf);
+			delta.f = NULL, delta.buf = NULL, delta.len = 0, delta.first = 0;
+		}
+	}
+	free(plain);
+	for (t = 0; t < STAT_LAST; t++) {
+		free(buf[t]);
+	}
+	for (i = 0; i < nfil; i++) {
+		free(fil[i].buf);
+	}
+	free(fil);
+}
+
+int statuswait(void)
+{
+	Status *s;
+	long ms = now(), left, wait = -1;
+
+	/* time until the first held back message is due, -1 when there are none */
+	for (s = stats; s; s = s->next) {
+		if (s->pending) {
+			left = MAX(0, s->last + 1000 / s->rate - ms);
+			wait = wait < 0 ? left : MIN(wait, left);
+		}
+	}
+	return wait;
 }
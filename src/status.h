@@ -6,5 +6,8 @@
 
 #pragma once
 
+void flushstatus(Status *s);
+void framestatus(Status *s);
 void printstatus(Status *s, int freeable);
+int statuswait(void);
 